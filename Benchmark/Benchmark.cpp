@@ -0,0 +1,393 @@
+// Benchmark.cpp : Throughput, memory and expiry-latency benchmarks for the Scheduler.
+//
+// Prints the results as JSON (in the layout of Google Benchmark's --benchmark_format=json) to stdout, and progress to stderr.
+//
+// Linux build (plain g++ or clang++, Boost headers installed):
+//   g++ -std=c++20 -O2 -I Scheduler Benchmark/Benchmark.cpp -o scheduler_benchmark -pthread
+//
+// Usage:
+//   scheduler_benchmark [timers]      (timers: size of the larger cases; default 100000)
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Scheduler.h"
+
+
+// Heap accounting (global operator new/delete), for the bytes-per-timer counters.
+// - Every allocation carries a header holding its size, so live bytes can be tracked without a platform-specific API.
+
+namespace // (Anonymous namespace)
+{
+    std::atomic<int64_t> g_live_bytes{ 0 };
+
+    constexpr std::size_t kHeaderSize = alignof(std::max_align_t);
+
+    void* AllocateCounted(const std::size_t size)
+    {
+        auto* block = static_cast<unsigned char*>(std::malloc(size + kHeaderSize));
+        if (block == nullptr) {
+            throw std::bad_alloc();
+        }
+
+        *reinterpret_cast<std::size_t*>(block) = size;
+        g_live_bytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+        return block + kHeaderSize;
+    }
+
+    void DeallocateCounted(void* memory) noexcept
+    {
+        if (memory == nullptr) {
+            return;
+        }
+
+        auto* block = static_cast<unsigned char*>(memory) - kHeaderSize;
+        g_live_bytes.fetch_sub(static_cast<int64_t>(*reinterpret_cast<std::size_t*>(block)), std::memory_order_relaxed);
+        std::free(block);
+    }
+}
+
+void* operator new(const std::size_t size) { return AllocateCounted(size); }
+void* operator new[](const std::size_t size) { return AllocateCounted(size); }
+void operator delete(void* memory) noexcept { DeallocateCounted(memory); }
+void operator delete[](void* memory) noexcept { DeallocateCounted(memory); }
+void operator delete(void* memory, std::size_t) noexcept { DeallocateCounted(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { DeallocateCounted(memory); }
+
+
+namespace // (Anonymous namespace)
+{
+    using Clock = std::chrono::steady_clock;
+
+    // BenchmarkResult: One entry of the "benchmarks" array.
+    // - real_time: Wall-clock nanoseconds per iteration (per timer, or per operation).
+    // - counters:  Additional named values (bytes per timer, percentiles, contention counters, ...).
+    struct BenchmarkResult
+    {
+        std::string name;
+        uint64_t iterations{ 0 };
+        double real_time{ 0 };
+        std::vector<std::pair<std::string, double>> counters{};
+    };
+
+    std::vector<BenchmarkResult> g_results{};
+
+    const char* EngineName(const TimerEngine engine)
+    {
+        return engine == TimerEngine::AsioTimer ? "AsioTimer" : "TimingWheel";
+    }
+
+    double NanosecondsSince(const Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    // WaitUntil(predicate): Polls `predicate` until it holds (returns false after a minute).
+    bool WaitUntil(const std::function<bool()>& predicate)
+    {
+        const auto give_up = Clock::now() + std::chrono::minutes(1);
+        while (!predicate()) {
+            if (Clock::now() > give_up) {
+                std::cerr << "benchmark timed out" << std::endl;
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        return true;
+    }
+
+    // Applied(scheduler, active): All submissions have reached the engine, which now holds `active` timers.
+    bool Applied(const Scheduler& scheduler, const uint64_t active)
+    {
+        const SchedulerStats stats = scheduler.Stats();
+        return stats.queue_depth == 0 && stats.active_timers == active;
+    }
+
+    void AddPercentiles(BenchmarkResult& result, const std::string& prefix, const LatencyHistogramSnapshot& histogram)
+    {
+        result.counters.emplace_back(prefix + "_p50_ns", static_cast<double>(histogram.Percentile(50).count()));
+        result.counters.emplace_back(prefix + "_p90_ns", static_cast<double>(histogram.Percentile(90).count()));
+        result.counters.emplace_back(prefix + "_p99_ns", static_cast<double>(histogram.Percentile(99).count()));
+        result.counters.emplace_back(prefix + "_p999_ns", static_cast<double>(histogram.Percentile(99.9).count()));
+        result.counters.emplace_back(prefix + "_max_ns", static_cast<double>(histogram.Max().count()));
+    }
+
+
+    // BM_ScheduleN: Schedules `timers` far-future timers and waits until the engine holds all of them.
+    // - real_time: Nanoseconds per timer, end to end (calling thread plus engine).
+    // - call_ns_per_timer: The calling thread's share only.
+    // - bytes_per_timer: Heap growth per pending timer (node, callback, engine and index storage).
+    void BM_ScheduleN(const TimerEngine engine, const uint64_t timers)
+    {
+        const int64_t bytes_before = g_live_bytes.load();
+        {
+            Scheduler scheduler{ SchedulerOptions{ .engine = engine } };
+            const int64_t bytes_baseline = g_live_bytes.load();
+
+            const auto start = Clock::now();
+            for (uint64_t timer_id = 0; timer_id < timers; ++timer_id) {
+                scheduler.ScheduleTimer(timer_id, std::chrono::hours(1), [](uint64_t) {});
+            }
+            const double call_ns = NanosecondsSince(start);
+            WaitUntil([&] { return Applied(scheduler, timers); });
+            const double total_ns = NanosecondsSince(start);
+
+            BenchmarkResult result{ std::string("BM_ScheduleN/") + EngineName(engine) + "/" + std::to_string(timers), timers, total_ns / timers };
+            result.counters.emplace_back("call_ns_per_timer", call_ns / timers);
+            result.counters.emplace_back("bytes_per_timer", static_cast<double>(g_live_bytes.load() - bytes_baseline) / timers);
+            result.counters.emplace_back("scheduler_bytes", static_cast<double>(bytes_baseline - bytes_before));
+            g_results.push_back(std::move(result));
+        }
+    }
+
+
+    // BM_ScheduleCancelChurn: Schedules and immediately cancels `operations` timers (with a pool of pending timers present).
+    // - real_time: Nanoseconds per schedule+cancel pair, end to end.
+    void BM_ScheduleCancelChurn(const TimerEngine engine, const uint64_t operations)
+    {
+        Scheduler scheduler{ SchedulerOptions{ .engine = engine } };
+
+        // Background population, so the engine is not trivially empty:
+        constexpr uint64_t kPending = 10000;
+        for (uint64_t timer_id = 0; timer_id < kPending; ++timer_id) {
+            scheduler.ScheduleTimer(timer_id, std::chrono::hours(1), [](uint64_t) {});
+        }
+        WaitUntil([&] { return Applied(scheduler, kPending); });
+
+        const auto start = Clock::now();
+        for (uint64_t i = 0; i < operations; ++i) {
+            const uint64_t timer_id = kPending + i;
+            scheduler.ScheduleTimer(timer_id, std::chrono::seconds(10 + i % 1000), [](uint64_t) {});
+            scheduler.CancelTimer(timer_id);
+        }
+        WaitUntil([&] { return Applied(scheduler, kPending); });
+
+        BenchmarkResult result{ std::string("BM_ScheduleCancelChurn/") + EngineName(engine) + "/" + std::to_string(operations), operations,
+            NanosecondsSince(start) / operations };
+        result.counters.emplace_back("largest_drain", static_cast<double>(scheduler.SubmissionStats().largest_drain));
+        g_results.push_back(std::move(result));
+    }
+
+
+    // BM_IdleTouch: Keeps 1000 sessions' idle timeouts alive through `packets` packets (round-robin over the sessions).
+    // - real_time: Nanoseconds per packet with IdleTimeout::Touch() (calling thread; the engine is not involved).
+    // - reschedule_ns_per_packet: The same with RescheduleTimer() per packet, end to end.
+    void BM_IdleTouch(const TimerEngine engine, const uint64_t packets)
+    {
+        Scheduler scheduler{ SchedulerOptions{ .engine = engine } };
+
+        constexpr uint64_t kSessions = 1000;
+        std::vector<IdleTimeout> sessions{};
+        for (uint64_t timer_id = 0; timer_id < kSessions; ++timer_id) {
+            sessions.push_back(scheduler.ScheduleIdleTimeout(timer_id, std::chrono::seconds(30), [](uint64_t) {}));
+        }
+        WaitUntil([&] { return Applied(scheduler, kSessions); });
+
+        auto start = Clock::now();
+        for (uint64_t i = 0; i < packets; ++i) {
+            sessions[i % kSessions].Touch();
+        }
+        const double touch_ns = NanosecondsSince(start) / packets;
+
+        start = Clock::now();
+        for (uint64_t i = 0; i < packets; ++i) {
+            scheduler.RescheduleTimer(i % kSessions, std::chrono::seconds(30));
+        }
+        WaitUntil([&] { return Applied(scheduler, kSessions); });
+        const double reschedule_ns = NanosecondsSince(start) / packets;
+
+        BenchmarkResult result{ std::string("BM_IdleTouch/") + EngineName(engine) + "/" + std::to_string(packets), packets, touch_ns };
+        result.counters.emplace_back("reschedule_ns_per_packet", reschedule_ns);
+        g_results.push_back(std::move(result));
+    }
+
+
+    // BM_FireStorm: `timers` timers with the same deadline.
+    // - real_time: Nanoseconds per fired timer, from the deadline to the last callback.
+    // - lateness_*: Per-timer lateness (the last timer of the storm waits for all the callbacks before it).
+    void BM_FireStorm(const TimerEngine engine, const std::size_t worker_threads, const uint64_t timers)
+    {
+        Scheduler scheduler{ SchedulerOptions{ .engine = engine, .worker_threads = worker_threads } };
+
+        std::atomic<uint64_t> fired{ 0 };
+        const auto deadline = Clock::now() + std::chrono::milliseconds(200) + std::chrono::microseconds(2 * timers);
+        for (uint64_t timer_id = 0; timer_id < timers; ++timer_id) {
+            scheduler.ScheduleTimer(timer_id, deadline, [&fired](uint64_t) { fired.fetch_add(1, std::memory_order_relaxed); });
+        }
+
+        if (!WaitUntil([&] { return fired.load() == timers; })) {
+            return;
+        }
+        const double storm_ns = std::chrono::duration<double, std::nano>(Clock::now() - deadline).count();
+
+        const SchedulerStats stats = scheduler.Stats();
+        BenchmarkResult result{ std::string("BM_FireStorm/") + EngineName(engine) + "/threads:" + std::to_string(worker_threads) + "/" + std::to_string(timers),
+            timers, storm_ns / timers };
+        result.counters.emplace_back("timers_per_second", timers / (storm_ns / 1e9));
+        AddPercentiles(result, "lateness", stats.lateness);
+        g_results.push_back(std::move(result));
+    }
+
+
+    // BM_MultiProducer: `producers` threads schedule and cancel `operations` timers each, concurrently.
+    // - real_time: Nanoseconds per operation (schedule or cancel), end to end, across all producers.
+    // - call_ns_per_operation: The producers' share only (node allocation and submission, until the last producer is done).
+    // - The submission queue's contention counters show how the producers interacted.
+    void BM_MultiProducer(const TimerEngine engine, const unsigned producers, const uint64_t operations)
+    {
+        Scheduler scheduler{ SchedulerOptions{ .engine = engine } };
+
+        std::atomic<bool> go{ false };
+        std::vector<std::thread> threads{};
+        for (unsigned producer = 0; producer < producers; ++producer) {
+            threads.emplace_back([&, producer] {
+                while (!go.load()) {
+                    std::this_thread::yield();
+                }
+                for (uint64_t i = 0; i < operations; ++i) {
+                    const uint64_t timer_id = (static_cast<uint64_t>(producer) << 40) | i;
+                    scheduler.ScheduleTimer(timer_id, std::chrono::hours(1), [](uint64_t) {});
+                    if (i % 2 == 1) {
+                        scheduler.CancelTimer(timer_id);
+                    }
+                }
+                });
+        }
+
+        const auto start = Clock::now();
+        go = true;
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        const double call_ns = NanosecondsSince(start);
+        const uint64_t expected = producers * (operations - operations / 2);
+        WaitUntil([&] { return Applied(scheduler, expected); });
+        const double total_ns = NanosecondsSince(start);
+
+        const uint64_t total_operations = producers * (operations + operations / 2);
+        const SubmissionQueueStats submissions = scheduler.SubmissionStats();
+        BenchmarkResult result{ std::string("BM_MultiProducer/") + EngineName(engine) + "/producers:" + std::to_string(producers), total_operations,
+            total_ns / total_operations };
+        result.counters.emplace_back("operations_per_second", total_operations / (total_ns / 1e9));
+        result.counters.emplace_back("call_ns_per_operation", call_ns / total_operations);
+        result.counters.emplace_back("cas_retries", static_cast<double>(submissions.cas_retries));
+        result.counters.emplace_back("overflows", static_cast<double>(submissions.overflows));
+        result.counters.emplace_back("drains", static_cast<double>(submissions.drains));
+        result.counters.emplace_back("largest_drain", static_cast<double>(submissions.largest_drain));
+        g_results.push_back(std::move(result));
+    }
+
+
+    // BM_Jitter: `timers` timers spread 1 ms apart on an otherwise idle Scheduler.
+    // - real_time: Mean lateness (callback start minus deadline).
+    // - lateness_*: Lateness percentiles, from the Scheduler's own histogram.
+    void BM_Jitter(const TimerEngine engine, const uint64_t timers)
+    {
+        Scheduler scheduler{ SchedulerOptions{ .engine = engine } };
+
+        std::atomic<uint64_t> fired{ 0 };
+        const auto start = Clock::now() + std::chrono::milliseconds(10);
+        for (uint64_t timer_id = 0; timer_id < timers; ++timer_id) {
+            scheduler.ScheduleTimer(timer_id, start + std::chrono::milliseconds(timer_id), [&fired](uint64_t) { fired.fetch_add(1, std::memory_order_relaxed); });
+        }
+
+        if (!WaitUntil([&] { return fired.load() == timers; })) {
+            return;
+        }
+
+        const SchedulerStats stats = scheduler.Stats();
+        BenchmarkResult result{ std::string("BM_Jitter/") + EngineName(engine) + "/" + std::to_string(timers), timers,
+            static_cast<double>(stats.lateness.Mean().count()) };
+        AddPercentiles(result, "lateness", stats.lateness);
+        g_results.push_back(std::move(result));
+    }
+
+
+    std::string JsonEscape(const std::string& text)
+    {
+        std::string escaped{};
+        for (const char c : text) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    void PrintJson(std::ostream& out)
+    {
+        const std::time_t now = std::time(nullptr);
+        char date[32]{};
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+        out << "{\n";
+        out << "  \"context\": {\n";
+        out << "    \"date\": \"" << date << "\",\n";
+        out << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+        out << "    \"library\": \"Scheduler\",\n";
+#if defined(SCHEDULER_USE_TIMERFD)
+        out << "    \"wheel_timer\": \"timerfd\"\n";
+#else
+        out << "    \"wheel_timer\": \"asio\"\n";
+#endif
+        out << "  },\n";
+        out << "  \"benchmarks\": [";
+        for (std::size_t i = 0; i < g_results.size(); ++i) {
+            const BenchmarkResult& result = g_results[i];
+            out << (i == 0 ? "\n" : ",\n");
+            out << "    {\n";
+            out << "      \"name\": \"" << JsonEscape(result.name) << "\",\n";
+            out << "      \"run_type\": \"iteration\",\n";
+            out << "      \"iterations\": " << result.iterations << ",\n";
+            out << "      \"real_time\": " << result.real_time << ",\n";
+            for (const auto& [name, value] : result.counters) {
+                out << "      \"" << JsonEscape(name) << "\": " << value << ",\n";
+            }
+            out << "      \"time_unit\": \"ns\"\n";
+            out << "    }";
+        }
+        out << "\n  ]\n";
+        out << "}" << std::endl;
+    }
+
+}
+
+
+// Main
+int main(int argc, char* argv[])
+{
+    const uint64_t timers = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    if (timers == 0) {
+        std::cerr << "usage: " << argv[0] << " [timers]" << std::endl;
+        return 1;
+    }
+
+    const unsigned cpus = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (const TimerEngine engine : { TimerEngine::AsioTimer, TimerEngine::TimingWheel }) {
+        std::cerr << "* " << EngineName(engine) << std::endl;
+
+        BM_ScheduleN(engine, timers);
+        BM_ScheduleCancelChurn(engine, timers);
+        BM_IdleTouch(engine, timers);
+        BM_FireStorm(engine, 1, timers);
+        if (cpus > 1) {
+            BM_FireStorm(engine, cpus, timers);
+        }
+        for (unsigned producers : { 1u, 2u, 4u, 8u }) {
+            BM_MultiProducer(engine, producers, timers / producers);
+        }
+        BM_Jitter(engine, std::min<uint64_t>(timers, 2000));
+    }
+
+    PrintJson(std::cout);
+}
@@ -0,0 +1,422 @@
+#ifndef AMITG_FC_EVENT_SINK
+#define AMITG_FC_EVENT_SINK
+
+/*
+    EventSink.h
+    Copyright (c) 2024, Amit Gefen
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "SubmissionQueue.h"
+
+
+// SchedulerEventKind: What a SchedulerEvent reports.
+// - ScheduleFailed, CancelFailed, RescheduleFailed, SpawnFailed: A call failed (e.g., out of memory).
+// - Rejected:          A call was refused because the Scheduler is shut down (expected while shutting down).
+// - TimerWaitFailed:   The engine's wait for a timer failed (error carries the error code); the timer is dropped.
+// - EngineFailed:      The timer engine failed to apply a submission, post work to itself, or stop.
+// - CallbackThrew:     A timer callback threw (see CallbackErrorPolicy).
+// - ErrorHandlerThrew: SchedulerOptions::callback_error_handler threw.
+// - ShutdownFailed:    Shutting down from the destructor failed.
+// - ThreadFailed:      A service (or shard) thread ended with an exception.
+// - PinFailed:         A shard thread could not be pinned to its CPU (ShardedScheduler).
+// - StoreFailed:       The persistent timer store could not record, erase or reload a timer (see TimerStore).
+enum class SchedulerEventKind : uint8_t
+{
+    ScheduleFailed,
+    CancelFailed,
+    RescheduleFailed,
+    SpawnFailed,
+    Rejected,
+    TimerWaitFailed,
+    EngineFailed,
+    CallbackThrew,
+    ErrorHandlerThrew,
+    ShutdownFailed,
+    ThreadFailed,
+    PinFailed,
+    StoreFailed
+};
+
+// SchedulerEventText(kind): The log text of an event kind.
+constexpr std::string_view SchedulerEventText(const SchedulerEventKind kind) noexcept
+{
+    switch (kind) {
+    case SchedulerEventKind::ScheduleFailed: return "error scheduling timer";
+    case SchedulerEventKind::CancelFailed: return "error cancelling timer";
+    case SchedulerEventKind::RescheduleFailed: return "error rescheduling timer";
+    case SchedulerEventKind::SpawnFailed: return "error spawning task";
+    case SchedulerEventKind::Rejected: return "request rejected";
+    case SchedulerEventKind::TimerWaitFailed: return "error waiting on timer";
+    case SchedulerEventKind::EngineFailed: return "error in the timer engine";
+    case SchedulerEventKind::CallbackThrew: return "exception in timer callback";
+    case SchedulerEventKind::ErrorHandlerThrew: return "exception in the callback error handler";
+    case SchedulerEventKind::ShutdownFailed: return "error shutting down the scheduler";
+    case SchedulerEventKind::ThreadFailed: return "exception in service thread";
+    case SchedulerEventKind::PinFailed: return "error pinning a thread";
+    case SchedulerEventKind::StoreFailed: return "error in the persistent timer store";
+    }
+    return "scheduler event";
+}
+
+
+// SchedulerEvent: One structured error or event of a Scheduler (trivially copyable, so it fits a lock-free ring).
+// - timer_:   The timer it concerns, if any.
+// - error_:   The error code, if the failure came with one.
+// - time_:    When it happened (wall clock, for logs).
+// - message_: The detail (usually the exception's message), NUL-terminated, truncated to fit.
+struct SchedulerEvent
+{
+    SchedulerEventKind kind_{ SchedulerEventKind::EngineFailed };
+    std::optional<uint64_t> timer_{};
+    std::error_code error_{};
+    std::chrono::system_clock::time_point time_{};
+    std::array<char, 128> message_{};
+
+    std::string_view Message() const noexcept { return std::string_view(message_.data()); }
+};
+
+// MakeSchedulerEvent(kind, timer, message, error): An event stamped with the current time.
+inline SchedulerEvent MakeSchedulerEvent(const SchedulerEventKind kind, const std::optional<uint64_t> timer,
+    const std::string_view message, const std::error_code error = {}) noexcept
+{
+    SchedulerEvent event{};
+    event.kind_ = kind;
+    event.timer_ = timer;
+    event.error_ = error;
+    event.time_ = std::chrono::system_clock::now();
+    const std::size_t length = std::min(message.size(), event.message_.size() - 1);
+    if (length > 0) {
+        std::memcpy(event.message_.data(), message.data(), length);
+    }
+    return event;
+}
+
+// FormatSchedulerEvent(out, event)
+//
+// Appends the log line of an event to `out`, e.g. "error scheduling timer (id = 7): std::bad_alloc".
+inline void FormatSchedulerEvent(std::string& out, const SchedulerEvent& event)
+{
+    out += SchedulerEventText(event.kind_);
+    if (event.timer_) {
+        out += " (id = ";
+        out += std::to_string(*event.timer_);
+        out += ')';
+    }
+    if (!event.Message().empty()) {
+        out += ": ";
+        out += event.Message();
+    }
+    out += '\n';
+}
+
+
+// SchedulerEventSink
+//
+// Receives the errors and events of Schedulers (see SchedulerOptions::event_sink).
+// - Publish() is called on the thread where the event happened, which may be a timer thread in the middle of a storm of
+//   them: it must be quick, must not block on I/O, and must not throw. Several threads may call it at once.
+// - Flush() blocks until the events published so far are written out; called before std::terminate().
+
+class SchedulerEventSink
+{
+public:
+
+    virtual ~SchedulerEventSink() = default;
+
+    virtual void Publish(const SchedulerEvent& event) noexcept = 0;
+
+    virtual void Flush() noexcept
+    {
+    }
+};
+
+
+// AsyncLogSinkOptions: Construction-time configuration of an AsyncLogSink.
+struct AsyncLogSinkOptions
+{
+    // capacity: Ring slots (rounded up to a power of two). Events published while the ring is full are dropped (counted).
+    std::size_t capacity{ 256 };
+
+    // max_events_per_second: Rate limit; events past it within a second are suppressed (counted, and summarized in the log).
+    // Zero: no limit.
+    uint32_t max_events_per_second{ 1000 };
+
+    // silenced: Kinds that are never logged (e.g., SchedulerEventKind::Rejected for calls racing with an orderly shutdown).
+    std::vector<SchedulerEventKind> silenced{};
+
+    // stream: Where the log lines go (must outlive the sink).
+    std::ostream* stream{ &std::cerr };
+};
+
+
+// AsyncLogSinkStats: Counters of an AsyncLogSink (a relaxed snapshot).
+// - published:  Events accepted into the ring.
+// - written:    Events written to the stream.
+// - silenced:   Events of a silenced kind.
+// - suppressed: Events over the rate limit.
+// - dropped:    Events that found the ring full.
+struct AsyncLogSinkStats
+{
+    uint64_t published{ 0 };
+    uint64_t written{ 0 };
+    uint64_t silenced{ 0 };
+    uint64_t suppressed{ 0 };
+    uint64_t dropped{ 0 };
+};
+
+
+// AsyncLogSink
+//
+// The default SchedulerEventSink: a lock-free ring of events (a SubmissionQueue that drops instead of growing), written to
+// a stream by a background thread.
+// - Publish() costs a clock read, a few relaxed atomics and one ring slot; the first event into an idle ring also wakes the
+//   writer (a futex wake). Nothing is formatted, locked or flushed on the publishing thread.
+// - The writer formats a whole batch and writes and flushes it at once. It is started by the first event, so a process
+//   that never logs has no extra thread.
+// - The rate limit counts events per steady-clock second (approximately, at the second boundary).
+
+class AsyncLogSink final : public SchedulerEventSink
+{
+public:
+
+    explicit AsyncLogSink(const AsyncLogSinkOptions& options = AsyncLogSinkOptions{}) :
+        events_(options.capacity),
+        max_events_per_second_(options.max_events_per_second),
+        silenced_(SilencedMask(options.silenced)),
+        stream_(*options.stream)
+    {
+    }
+
+    AsyncLogSink(const AsyncLogSink&) = delete;
+    AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+
+    // Destructor: Writes the events still queued, then stops the writer.
+    ~AsyncLogSink() override
+    {
+        if (writer_.joinable()) {
+            stopping_.store(true);
+            Wake();
+            writer_.join();
+        }
+    }
+
+    void Publish(const SchedulerEvent& event) noexcept override
+    {
+        if ((silenced_ >> static_cast<unsigned>(event.kind_)) & 1u) {
+            silenced_count_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (!Admit()) {
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        std::call_once(writer_started_, [this] { StartWriter(); });
+        if (!writer_.joinable()) {
+            WriteNow(event);
+            return;
+        }
+
+        const std::optional<bool> pushed = events_.TryPush(event);
+        if (!pushed) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        published_.fetch_add(1, std::memory_order_release);
+        if (*pushed) {
+            Wake();
+        }
+    }
+
+    void Flush() noexcept override
+    {
+        const uint64_t target = published_.load(std::memory_order_acquire);
+        for (uint64_t written = written_.load(std::memory_order_acquire); written < target; written = written_.load(std::memory_order_acquire)) {
+            written_.wait(written, std::memory_order_acquire);
+        }
+    }
+
+    AsyncLogSinkStats Stats() const noexcept
+    {
+        AsyncLogSinkStats stats{};
+        stats.published = published_.load(std::memory_order_relaxed);
+        stats.written = written_.load(std::memory_order_relaxed);
+        stats.silenced = silenced_count_.load(std::memory_order_relaxed);
+        stats.suppressed = suppressed_.load(std::memory_order_relaxed);
+        stats.dropped = dropped_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+
+    static uint32_t SilencedMask(const std::vector<SchedulerEventKind>& kinds) noexcept
+    {
+        uint32_t mask = 0;
+        for (const SchedulerEventKind kind : kinds) {
+            mask |= 1u << static_cast<unsigned>(kind);
+        }
+        return mask;
+    }
+
+    // Admit(): Whether the rate limit lets one more event through in the current second.
+    bool Admit() noexcept
+    {
+        if (max_events_per_second_ == 0) {
+            return true;
+        }
+
+        const int64_t second = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        int64_t window = window_.load(std::memory_order_relaxed);
+        if (window != second && window_.compare_exchange_strong(window, second, std::memory_order_relaxed)) {
+            window_events_.store(0, std::memory_order_relaxed);
+        }
+        return window_events_.fetch_add(1, std::memory_order_relaxed) < max_events_per_second_;
+    }
+
+    // StartWriter(): Starts the writer thread; if that fails, events are written synchronously (see WriteNow()).
+    void StartWriter() noexcept
+    {
+        try {
+            writer_ = std::thread([this] { Writer(); });
+        } catch (const std::exception&) {
+        }
+    }
+
+    void Wake() noexcept
+    {
+        wake_.fetch_add(1, std::memory_order_release);
+        wake_.notify_one();
+    }
+
+    // Writer()
+    //
+    // The writer thread: drains the ring whenever Publish() wakes it, and writes each batch with one write and one flush,
+    // followed by a summary of the events suppressed or dropped since the last one.
+    void Writer()
+    {
+        std::string batch{};
+        uint64_t reported_suppressed = 0;
+        uint64_t reported_dropped = 0;
+
+        for (;;) {
+            const uint32_t wake = wake_.load(std::memory_order_acquire);
+            const bool stopping = stopping_.load();
+
+            uint64_t count = 0;
+            batch.clear();
+            try {
+                while (events_.Drain([&batch, &count](const SchedulerEvent& event) {
+                    ++count;
+                    FormatSchedulerEvent(batch, event);
+                    })) {
+                }
+
+                const uint64_t suppressed = suppressed_.load(std::memory_order_relaxed);
+                const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+                if (suppressed != reported_suppressed || dropped != reported_dropped) {
+                    batch += std::to_string(suppressed - reported_suppressed) + " scheduler events suppressed (rate limit), " +
+                        std::to_string(dropped - reported_dropped) + " dropped (queue full)\n";
+                    reported_suppressed = suppressed;
+                    reported_dropped = dropped;
+                }
+
+                if (!batch.empty()) {
+                    stream_ << batch;
+                    stream_.flush();
+                }
+            } catch (const std::exception&) {
+                // (Out of memory formatting, or a stream that throws: the batch is lost, the writer goes on)
+            }
+
+            if (count > 0) {
+                written_.fetch_add(count, std::memory_order_release);
+                written_.notify_all();
+            }
+
+            if (stopping) {
+                return;
+            }
+            wake_.wait(wake, std::memory_order_acquire);
+        }
+    }
+
+    // WriteNow(event): Writes one event synchronously (only if the writer thread could not be started).
+    void WriteNow(const SchedulerEvent& event) noexcept
+    {
+        try {
+            std::string line{};
+            FormatSchedulerEvent(line, event);
+            const std::lock_guard lock(write_mutex_);
+            stream_ << line;
+            stream_.flush();
+        } catch (const std::exception&) {
+        }
+    }
+
+    // - events_:          The ring; Publish() is its producer, Writer() its consumer.
+    // - wake_:            Bumped (and notified) to wake the writer; stopping_ makes it exit after one last drain.
+    // - window_, window_events_: The rate limit's current second and the events admitted in it.
+    SubmissionQueue<SchedulerEvent> events_;
+    const uint32_t max_events_per_second_;
+    const uint32_t silenced_;
+    std::ostream& stream_;
+
+    std::once_flag writer_started_{};
+    std::thread writer_{};
+    std::mutex write_mutex_{};
+    std::atomic<uint32_t> wake_{ 0 };
+    std::atomic<bool> stopping_{ false };
+    std::atomic<int64_t> window_{ 0 };
+    std::atomic<uint32_t> window_events_{ 0 };
+
+    std::atomic<uint64_t> published_{ 0 };
+    std::atomic<uint64_t> written_{ 0 };
+    std::atomic<uint64_t> silenced_count_{ 0 };
+    std::atomic<uint64_t> suppressed_{ 0 };
+    std::atomic<uint64_t> dropped_{ 0 };
+};
+
+
+// DefaultEventSink(): The process-wide AsyncLogSink (to std::cerr) used by Schedulers that are not given a sink of their own.
+inline std::shared_ptr<SchedulerEventSink> DefaultEventSink()
+{
+    static const std::shared_ptr<SchedulerEventSink> sink = std::make_shared<AsyncLogSink>();
+    return sink;
+}
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef AMITG_FC_IDLE_TIMEOUT
+#define AMITG_FC_IDLE_TIMEOUT
+
+/*
+    IdleTimeout.h
+    Copyright (c) 2024, Amit Gefen
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+
+// IdleTimeoutState
+//
+// The last-activity time shared by an idle timeout's handles and its timer node (see Scheduler::ScheduleIdleTimeout()).
+// - A single allocation with an intrusive reference count (one reference for each handle, and one for the node).
+// - The time is steady_clock ticks, written with relaxed stores: the timer engine only needs to see some recent activity,
+//   not a consistent order with anything else.
+
+class IdleTimeoutState final
+{
+public:
+
+    IdleTimeoutState() noexcept = default;
+
+    IdleTimeoutState(const IdleTimeoutState&) = delete;
+    IdleTimeoutState& operator=(const IdleTimeoutState&) = delete;
+
+    void Touch() noexcept
+    {
+        last_activity_.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
+    std::chrono::steady_clock::time_point LastActivity() const noexcept
+    {
+        return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(last_activity_.load(std::memory_order_relaxed)));
+    }
+
+    void AddReference() noexcept
+    {
+        references_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Release() noexcept
+    {
+        if (references_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+private:
+
+    std::atomic<std::chrono::steady_clock::rep> last_activity_{ std::chrono::steady_clock::now().time_since_epoch().count() };
+    std::atomic<uint32_t> references_{ 1 };
+};
+
+
+// IdleTimeout
+//
+// A small, copyable handle to an idle timeout (see Scheduler::ScheduleIdleTimeout()).
+// - Touch() records activity: one steady_clock read and one relaxed store, with no call into the Scheduler. The timer is
+//   not re-armed; when its deadline comes, the engine finds the recent activity and pushes it back (see Scheduler::Expire()).
+// - Touching a timeout that already fired, was cancelled or replaced has no effect.
+// - May outlive the Scheduler. Touching an empty handle (default constructed, moved from, or returned for a timeout that
+//   could not be scheduled) has no effect; its LastActivity() must not be read.
+
+class IdleTimeout final
+{
+public:
+
+    IdleTimeout() noexcept = default;
+
+    explicit IdleTimeout(IdleTimeoutState* state) noexcept : state_(state)
+    {
+    }
+
+    IdleTimeout(const IdleTimeout& other) noexcept : state_(other.state_)
+    {
+        if (state_ != nullptr) {
+            state_->AddReference();
+        }
+    }
+
+    IdleTimeout(IdleTimeout&& other) noexcept : state_(std::exchange(other.state_, nullptr))
+    {
+    }
+
+    IdleTimeout& operator=(IdleTimeout other) noexcept
+    {
+        std::swap(state_, other.state_);
+        return *this;
+    }
+
+    ~IdleTimeout()
+    {
+        if (state_ != nullptr) {
+            state_->Release();
+        }
+    }
+
+    explicit operator bool() const noexcept { return state_ != nullptr; }
+
+    void Touch() noexcept
+    {
+        if (state_ != nullptr) {
+            state_->Touch();
+        }
+    }
+
+    // LastActivity(): When Touch() was last called (or the timeout was scheduled, if never).
+    std::chrono::steady_clock::time_point LastActivity() const noexcept { return state_->LastActivity(); }
+
+private:
+
+    IdleTimeoutState* state_{ nullptr };
+};
+
+#endif
@@ -0,0 +1,232 @@
+#ifndef AMITG_FC_LATENCY_HISTOGRAM
+#define AMITG_FC_LATENCY_HISTOGRAM
+
+/*
+    LatencyHistogram.h
+    Copyright (c) 2024, Amit Gefen
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+
+// Log-linear bucketing shared by LatencyHistogram and LatencyHistogramSnapshot (HDR histogram style).
+// - Values below 2^kLatencySubBucketBits nanoseconds each have their own bucket; above that, every power-of-two range is
+//   split into 16 linear buckets, so any recorded value is known within 1/16 (about 6%) of itself.
+// - Covers the full uint64_t range of nanoseconds in kLatencyBuckets buckets.
+inline constexpr unsigned kLatencySubBucketBits = 5;
+inline constexpr std::size_t kLatencyBuckets = ((64 - kLatencySubBucketBits + 2) << (kLatencySubBucketBits - 1));
+
+// LatencyBucketIndex(value): The bucket of a value in nanoseconds.
+constexpr std::size_t LatencyBucketIndex(const uint64_t value) noexcept
+{
+    const unsigned width = static_cast<unsigned>(std::bit_width(value));
+    const unsigned exponent = width > kLatencySubBucketBits ? width - kLatencySubBucketBits : 0;
+    return (static_cast<std::size_t>(exponent) << (kLatencySubBucketBits - 1)) + static_cast<std::size_t>(value >> exponent);
+}
+
+// LatencyBucketUpperBound(index): The highest value that falls into bucket `index`.
+constexpr uint64_t LatencyBucketUpperBound(const std::size_t index) noexcept
+{
+    if (index < (std::size_t{ 1 } << kLatencySubBucketBits)) {
+        return index;
+    }
+
+    const unsigned exponent = static_cast<unsigned>(index >> (kLatencySubBucketBits - 1)) - 1;
+    const uint64_t mantissa = index - (static_cast<std::size_t>(exponent) << (kLatencySubBucketBits - 1));
+    return ((mantissa + 1) << exponent) - 1;
+}
+
+
+// LatencyHistogramSnapshot: A copy of a LatencyHistogram at one point in time (see LatencyHistogram::Snapshot()).
+class LatencyHistogramSnapshot final
+{
+public:
+
+    // Count(): The number of recorded values.
+    uint64_t Count() const noexcept { return count_; }
+
+    // Mean(): The exact mean of the recorded values (zero if there are none).
+    std::chrono::nanoseconds Mean() const noexcept
+    {
+        return std::chrono::nanoseconds(count_ > 0 ? sum_ / count_ : 0);
+    }
+
+    // Max(): The exact largest recorded value.
+    std::chrono::nanoseconds Max() const noexcept { return std::chrono::nanoseconds(max_); }
+
+    // Percentile(percentile)
+    //
+    // Returns the value below or at which `percentile` percent (0 - 100) of the recorded values fall, rounded up to the
+    // upper bound of its bucket (never above Max()). Zero if nothing was recorded.
+    std::chrono::nanoseconds Percentile(const double percentile) const noexcept
+    {
+        if (count_ == 0) {
+            return std::chrono::nanoseconds(0);
+        }
+
+        const double clamped = percentile < 0.0 ? 0.0 : (percentile > 100.0 ? 100.0 : percentile);
+        uint64_t rank = static_cast<uint64_t>(clamped / 100.0 * static_cast<double>(count_) + 0.5);
+        rank = rank < 1 ? 1 : (rank > count_ ? count_ : rank);
+
+        uint64_t seen = 0;
+        for (std::size_t i = 0; i < buckets_.size(); ++i) {
+            seen += buckets_[i];
+            if (seen >= rank) {
+                const uint64_t bound = LatencyBucketUpperBound(i);
+                return std::chrono::nanoseconds(static_cast<int64_t>(bound < max_ ? bound : max_));
+            }
+        }
+        return Max();
+    }
+
+    // Merge(other)
+    //
+    // Adds the values recorded in `other` to this snapshot (e.g., to combine the histograms of several Schedulers).
+    void Merge(const LatencyHistogramSnapshot& other) noexcept
+    {
+        for (std::size_t i = 0; i < buckets_.size(); ++i) {
+            buckets_[i] += other.buckets_[i];
+        }
+        count_ += other.count_;
+        sum_ += other.sum_;
+        max_ = max_ > other.max_ ? max_ : other.max_;
+    }
+
+private:
+
+    friend class LatencyHistogram;
+
+    std::array<uint64_t, kLatencyBuckets> buckets_{};
+    uint64_t count_{ 0 };
+    uint64_t sum_{ 0 };
+    uint64_t max_{ 0 };
+};
+
+
+// LatencyHistogram
+//
+// Lock-free histogram of durations (HDR style; see LatencyBucketIndex()).
+// - Record() is lock-free: a handful of relaxed atomic increments, from any number of threads.
+// - The buckets are allocated in segments, one per power-of-two range, the first time a value falls into that range: an
+//   idle histogram takes a few hundred bytes, and one that records latencies of a few orders of magnitude a few KB. Record()
+//   allocates only then; if that allocation fails, the value is dropped.
+// - Snapshot() may run concurrently with Record(); each counter is read atomically, so a snapshot taken while values are
+//   being recorded can be off by the values in flight, but never torn.
+
+class LatencyHistogram final
+{
+public:
+
+    LatencyHistogram() noexcept = default;
+
+    ~LatencyHistogram()
+    {
+        for (auto& segment : segments_) {
+            delete segment.load(std::memory_order_relaxed);
+        }
+    }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    // Record(duration): Adds one value (negative durations count as zero).
+    void Record(const std::chrono::nanoseconds duration) noexcept
+    {
+        const uint64_t value = duration.count() > 0 ? static_cast<uint64_t>(duration.count()) : 0;
+
+        const std::size_t index = LatencyBucketIndex(value);
+        Segment* segment = SegmentFor(index);
+        if (segment == nullptr) {
+            return;
+        }
+
+        (*segment)[index % kSegmentBuckets].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t max = max_.load(std::memory_order_relaxed);
+        while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    LatencyHistogramSnapshot Snapshot() const noexcept
+    {
+        LatencyHistogramSnapshot snapshot{};
+        uint64_t count = 0;
+        for (std::size_t i = 0; i < kSegments; ++i) {
+            const Segment* segment = segments_[i].load(std::memory_order_acquire);
+            if (segment == nullptr) {
+                continue;
+            }
+
+            for (std::size_t j = 0; j < kSegmentBuckets; ++j) {
+                snapshot.buckets_[i * kSegmentBuckets + j] = (*segment)[j].load(std::memory_order_relaxed);
+                count += snapshot.buckets_[i * kSegmentBuckets + j];
+            }
+        }
+        snapshot.count_ = count; // (Counted from the buckets, so consistent with what Percentile() walks)
+        snapshot.sum_ = sum_.load(std::memory_order_relaxed);
+        snapshot.max_ = max_.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+private:
+
+    // Segment: The buckets of one power-of-two range (see LatencyBucketIndex()).
+    static constexpr std::size_t kSegmentBuckets = std::size_t{ 1 } << (kLatencySubBucketBits - 1);
+    static constexpr std::size_t kSegments = kLatencyBuckets / kSegmentBuckets;
+    using Segment = std::array<std::atomic<uint64_t>, kSegmentBuckets>;
+
+    // SegmentFor(index)
+    //
+    // Returns the segment of bucket `index`, allocating it if this is its first value (the thread that loses the race to
+    // publish its segment frees it and uses the winner's). Null if the allocation fails.
+    Segment* SegmentFor(const std::size_t index) noexcept
+    {
+        std::atomic<Segment*>& slot = segments_[index / kSegmentBuckets];
+        Segment* segment = slot.load(std::memory_order_acquire);
+        if (segment != nullptr) {
+            return segment;
+        }
+
+        Segment* created = new (std::nothrow) Segment{};
+        if (created == nullptr) {
+            return nullptr;
+        }
+
+        if (slot.compare_exchange_strong(segment, created, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            return created;
+        }
+        delete created;
+        return segment;
+    }
+
+    std::array<std::atomic<Segment*>, kSegments> segments_{};
+    std::atomic<uint64_t> sum_{ 0 };
+    std::atomic<uint64_t> max_{ 0 };
+};
+
+#endif
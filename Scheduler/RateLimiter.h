@@ -0,0 +1,313 @@
+#ifndef AMITG_FC_RATE_LIMITER
+#define AMITG_FC_RATE_LIMITER
+
+/*
+    RateLimiter.h
+    Copyright (c) 2024, Amit Gefen
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include "Scheduler.h"
+#include "TimerCallback.h"
+
+
+// RateLimiterOptions: Construction-time configuration of a RateLimiter's token bucket.
+struct RateLimiterOptions
+{
+    // rate: Tokens added to the bucket per second (at most one per nanosecond).
+    double rate{ 1000.0 };
+
+    // burst: The bucket's capacity (at least 1): how many tokens can be taken at once after an idle period. The bucket
+    //        starts full.
+    uint64_t burst{ 1 };
+};
+
+
+// RateLimiterStats: A snapshot of a RateLimiter's counters (see RateLimiter::Stats()).
+// - acquired: Granted calls: TryAcquire calls that succeeded, and Acquire callbacks that were run.
+// - rejected: TryAcquire calls that failed.
+// - waiting:  Acquire calls parked until their tokens refill.
+// - wakeups:  Expiries of the refill timer (each grants every parked call whose tokens have refilled by then).
+struct RateLimiterStats
+{
+    uint64_t acquired{ 0 };
+    uint64_t rejected{ 0 };
+    uint64_t waiting{ 0 };
+    uint64_t wakeups{ 0 };
+};
+
+
+// RateLimiter
+//
+// Token-bucket admission control on a Scheduler's clock (std::chrono::steady_clock) and timer engine.
+// - The bucket is a single atomic word (GCRA, the "virtual scheduling" form of a token bucket): the steady_clock time at
+//   which it will be full again. TryAcquire() is one compare-and-swap, and needs no refill thread.
+// - Acquire() reserves its tokens up front, so callers are served in order and TryAcquire() cannot take tokens that a
+//   parked caller is waiting for. Parked callers share one timer of the Scheduler (`timer_id`), armed for the first one
+//   due: one wakeup per refill serves every caller due by then, instead of a sleep/poll loop per caller.
+// - Callbacks run on the Scheduler's callback threads, under its callback error policy (see CallbackErrorPolicy).
+
+class RateLimiter final
+{
+public:
+
+    // Constructor (scheduler, timer_id, options)
+    //
+    // - `scheduler`: Runs the refill timer and the parked callbacks. Must outlive the RateLimiter.
+    // - `timer_id`: The id of the refill timer, in `scheduler`'s timer id space (not to be used for other timers).
+    RateLimiter(Scheduler& scheduler, const uint64_t timer_id, const RateLimiterOptions& options = RateLimiterOptions{}) :
+        state_(std::make_shared<State>(scheduler, timer_id, options))
+    {
+    }
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    // Destructor
+    //
+    // Cancels the refill timer. Parked Acquire callbacks are destroyed without being run.
+    ~RateLimiter()
+    {
+        state_->Close();
+    }
+
+    // TryAcquire(tokens)
+    //
+    // Takes `tokens` from the bucket if it holds that many (lock-free; any thread). Returns false, taking nothing, otherwise.
+    bool TryAcquire(const uint64_t tokens = 1) noexcept
+    {
+        return state_->TryAcquire(tokens);
+    }
+
+    // Acquire(tokens, callback)
+    //
+    // Reserves `tokens` and runs `callback()` on the Scheduler as soon as they have refilled (right away if the bucket holds
+    // them and no one is waiting before this caller).
+    // - `callback`: Any `void()` callable (may be move-only); stored inline up to TimerCallback's inline size.
+    // - Returns false if `tokens` exceeds the bucket's capacity: they could never be granted, so nothing is reserved and the
+    //   callback is not stored.
+    //
+    // Throws:
+    //   - std::bad_alloc if the parked callback cannot be stored.
+    template <typename Callback>
+    bool Acquire(const uint64_t tokens, Callback&& callback)
+    {
+        return state_->Acquire(tokens, TimerCallback(std::forward<Callback>(callback)));
+    }
+
+    // Available(): The tokens in the bucket now (zero while callers are parked for tokens not refilled yet).
+    uint64_t Available() const noexcept
+    {
+        return state_->Available();
+    }
+
+    // Stats(): A snapshot of the counters (see RateLimiterStats); lock-free.
+    RateLimiterStats Stats() const noexcept
+    {
+        return state_->Stats();
+    }
+
+private:
+
+    // State: The limiter, shared with the refill timer's callback, which may still be in flight after the RateLimiter is
+    // destroyed.
+    // - full_at_:   The bucket's GCRA "theoretical arrival time": steady_clock nanoseconds at which the bucket will be full
+    //               again. In the past, the bucket is full; more than `tolerance_` ahead of now, callers are parked.
+    // - interval_:  Nanoseconds per token (1 / rate).
+    // - tolerance_: Nanoseconds for a full bucket (burst * interval_).
+    // - waiters_:   Parked Acquire calls in reservation order, which is also due-time order (guarded by mutex_).
+    // - armed_:     The refill timer is scheduled, or OnRefill() is running and will re-arm it (guarded by mutex_).
+    struct State final : std::enable_shared_from_this<State>
+    {
+        struct Waiter
+        {
+            int64_t due_{ 0 };
+            TimerCallback callback_{};
+        };
+
+        State(Scheduler& scheduler, const uint64_t timer_id, const RateLimiterOptions& options) :
+            scheduler_(scheduler),
+            timer_id_(timer_id),
+            interval_(std::max<int64_t>(1, std::llround(1e9 / std::max(options.rate, 1e-9)))),
+            tolerance_(interval_ * static_cast<int64_t>(std::clamp<uint64_t>(options.burst, 1, std::numeric_limits<int64_t>::max() / interval_))),
+            burst_(static_cast<uint64_t>(tolerance_ / interval_))
+        {
+        }
+
+        bool TryAcquire(const uint64_t tokens) noexcept
+        {
+            if (tokens > burst_) {
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            const int64_t cost = static_cast<int64_t>(tokens) * interval_;
+            const int64_t now = Now();
+            int64_t full_at = full_at_.load(std::memory_order_relaxed);
+            for (;;) {
+                const int64_t next = std::max(full_at, now) + cost;
+                if (next - now > tolerance_) {
+                    rejected_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                if (full_at_.compare_exchange_weak(full_at, next, std::memory_order_relaxed)) {
+                    acquired_.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+        }
+
+        bool Acquire(const uint64_t tokens, TimerCallback callback)
+        {
+            if (tokens > burst_) {
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            // Reserves the tokens whether or not they are in the bucket yet; they are due once the bucket has refilled them.
+            const int64_t cost = static_cast<int64_t>(tokens) * interval_;
+            const int64_t now = Now();
+            int64_t full_at = full_at_.load(std::memory_order_relaxed);
+            while (!full_at_.compare_exchange_weak(full_at, std::max(full_at, now) + cost, std::memory_order_relaxed)) {
+            }
+
+            waiters_.push_back(Waiter{ std::max(full_at, now) + cost - tolerance_, std::move(callback) });
+            waiting_.fetch_add(1, std::memory_order_relaxed);
+            if (!armed_) {
+                Arm(waiters_.front().due_);
+            }
+            return true;
+        }
+
+        uint64_t Available() const noexcept
+        {
+            const int64_t now = Now();
+            const int64_t used = std::max(full_at_.load(std::memory_order_relaxed), now) - now;
+            return used < tolerance_ ? static_cast<uint64_t>((tolerance_ - used) / interval_) : 0;
+        }
+
+        RateLimiterStats Stats() const noexcept
+        {
+            RateLimiterStats stats{};
+            stats.acquired = acquired_.load(std::memory_order_relaxed);
+            stats.rejected = rejected_.load(std::memory_order_relaxed);
+            stats.waiting = waiting_.load(std::memory_order_relaxed);
+            stats.wakeups = wakeups_.load(std::memory_order_relaxed);
+            return stats;
+        }
+
+        // Close()
+        //
+        // Drops the parked callbacks (destroyed outside the lock, as they may own anything) and cancels the refill timer.
+        void Close()
+        {
+            std::deque<Waiter> dropped{};
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                dropped.swap(waiters_);
+                waiting_.store(0, std::memory_order_relaxed);
+            }
+            scheduler_.CancelTimer(timer_id_);
+        }
+
+        // Arm(due)
+        //
+        // Schedules the refill timer for `due` (steady_clock nanoseconds), replacing the pending one, if any (mutex_ held).
+        void Arm(const int64_t due)
+        {
+            armed_ = true;
+            const std::chrono::steady_clock::time_point deadline{ std::chrono::nanoseconds(due) };
+            scheduler_.ScheduleTimer(timer_id_, deadline, [state = shared_from_this()](uint64_t) { state->OnRefill(); });
+        }
+
+        // OnRefill()
+        //
+        // The refill timer's callback: runs the parked callbacks that are due, in order, and re-arms the timer for the next.
+        // - Each callback runs outside the lock, so it may call Acquire() (its call is served by this same wakeup if due).
+        // - A callback that throws is left to the Scheduler's callback error policy; the timer is re-armed for the rest first.
+        void OnRefill()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wakeups_.fetch_add(1, std::memory_order_relaxed);
+
+            while (!waiters_.empty()) {
+                if (waiters_.front().due_ > Now()) {
+                    Arm(waiters_.front().due_);
+                    return;
+                }
+
+                TimerCallback callback = std::move(waiters_.front().callback_);
+                waiters_.pop_front();
+                waiting_.fetch_sub(1, std::memory_order_relaxed);
+                acquired_.fetch_add(1, std::memory_order_relaxed);
+                lock.unlock();
+
+                try {
+                    callback();
+                } catch (...) {
+                    lock.lock();
+                    if (waiters_.empty()) {
+                        armed_ = false;
+                    } else {
+                        Arm(waiters_.front().due_);
+                    }
+                    throw;
+                }
+
+                lock.lock();
+            }
+            armed_ = false;
+        }
+
+        static int64_t Now() noexcept
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        Scheduler& scheduler_;
+        const uint64_t timer_id_;
+        const int64_t interval_;
+        const int64_t tolerance_;
+        const uint64_t burst_;
+        std::atomic<int64_t> full_at_{ std::numeric_limits<int64_t>::min() / 2 };
+        std::atomic<uint64_t> acquired_{ 0 };
+        std::atomic<uint64_t> rejected_{ 0 };
+        std::atomic<uint64_t> waiting_{ 0 };
+        std::atomic<uint64_t> wakeups_{ 0 };
+        std::mutex mutex_{};
+        std::deque<Waiter> waiters_{};
+        bool armed_{ false };
+    };
+
+    std::shared_ptr<State> state_;
+};
+
+#endif
@@ -25,16 +25,341 @@
 */
 
 #include <functional>
+#include <algorithm>
+#include <bit>
 #include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include <thread>
 #include <future>
 #include <syncstream>
 #include <iostream>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+// (<utility> above: Boost 1.74's awaitable.hpp uses std::exchange without including it)
 #include <boost/asio.hpp>
+#include "TimingWheel.h"
+#include "TimerIndex.h"
+#include "TimerCallback.h"
+#include "TimerPool.h"
+#include "SubmissionQueue.h"
+#include "LatencyHistogram.h"
+#include "Task.h"
+#include "TimerCompletion.h"
+#include "IdleTimeout.h"
+#include "EventSink.h"
+#include "TimerStore.h"
+#if defined(SCHEDULER_USE_TIMERFD)
+#include "TimerFd.h"
+#endif
+
+
+// TimerEngine: Selects how a Scheduler keeps track of its pending timers.
+// - AsioTimer:   One Boost Asio steady_timer per timer (Asio's timer heap; O(log n) insert; nanosecond deadlines).
+// - TimingWheel: A hierarchical timing wheel advanced by a single Asio timer (O(1) insert and cancel).
+//                Expiries are rounded up to the wheel tick (SchedulerOptions::wheel_tick).
+//                Built with SCHEDULER_USE_TIMERFD (Linux only), the wheel is advanced by a timerfd instead (see TimerFd.h).
+enum class TimerEngine
+{
+    AsioTimer,
+    TimingWheel
+};
+
+// WheelTimer: The timer that advances the TimingWheel engine (selected at compile time).
+#if defined(SCHEDULER_USE_TIMERFD)
+using WheelTimer = TimerFd;
+#else
+using WheelTimer = boost::asio::steady_timer;
+#endif
+
+
+// TimerDuration: A relative duration argument.
+// - Either milliseconds as uint32_t (the original API), or any std::chrono::duration (down to nanoseconds).
+// - Rounded up to whole nanoseconds, so a timer never fires early; negative durations count as zero.
+class TimerDuration final
+{
+public:
+
+    TimerDuration(const uint32_t milliseconds) noexcept : duration_(std::chrono::milliseconds(milliseconds))
+    {
+    }
+
+    template <typename Rep, typename Period>
+    TimerDuration(const std::chrono::duration<Rep, Period> duration) noexcept :
+        duration_(std::max(std::chrono::ceil<std::chrono::nanoseconds>(duration), std::chrono::nanoseconds(0)))
+    {
+    }
+
+    std::chrono::nanoseconds Get() const noexcept { return duration_; }
+
+private:
+
+    std::chrono::nanoseconds duration_{ 0 };
+};
+
+
+// TimerDeadline: When a timer expires.
+// - A relative duration (see TimerDuration), measured from the call that receives it, or
+// - An absolute std::chrono::steady_clock::time_point.
+// All deadlines are on the monotonic steady clock, so wall-clock adjustments (NTP, DST, manual changes) do not affect them.
+// - Optionally with a per-timer slack (WithSlack()), overriding SchedulerOptions::timer_slack.
+// - Optionally with a per-timer precision spin (WithSpin()), overriding SchedulerOptions::precision_spin.
+class TimerDeadline final
+{
+public:
+
+    TimerDeadline(const uint32_t milliseconds) noexcept : duration_(milliseconds)
+    {
+    }
+
+    template <typename Rep, typename Period>
+    TimerDeadline(const std::chrono::duration<Rep, Period> duration) noexcept : duration_(duration)
+    {
+    }
+
+    TimerDeadline(const std::chrono::steady_clock::time_point time_point) noexcept : time_point_(time_point)
+    {
+    }
+
+    // Resolve(): The absolute deadline (a relative one is measured from now).
+    std::chrono::steady_clock::time_point Resolve() const noexcept
+    {
+        return time_point_ ? *time_point_ : std::chrono::steady_clock::now() + duration_.Get();
+    }
+
+    // WithSlack(slack)
+    //
+    // Returns the same deadline, allowed to fire up to `slack` late so that it can share a wakeup with nearby timers
+    // (like Linux timerslack). Zero makes the timer exact, whatever SchedulerOptions::timer_slack says.
+    TimerDeadline WithSlack(const TimerDuration slack) const noexcept
+    {
+        TimerDeadline deadline(*this);
+        deadline.slack_ = slack.Get();
+        return deadline;
+    }
+
+    // Slack(): The per-timer slack, or std::nullopt for the Scheduler's default.
+    std::optional<std::chrono::nanoseconds> Slack() const noexcept { return slack_; }
+
+    // WithSpin(margin)
+    //
+    // Returns the same deadline, fired in precision mode: the engine wakes up `margin` early and the thread that runs the
+    // callback spins until the deadline (see SchedulerOptions::precision_spin). Zero turns precision mode off for this timer.
+    TimerDeadline WithSpin(const TimerDuration margin) const noexcept
+    {
+        TimerDeadline deadline(*this);
+        deadline.spin_ = margin.Get();
+        return deadline;
+    }
+
+    // Spin(): The per-timer precision spin margin, or std::nullopt for the Scheduler's default.
+    std::optional<std::chrono::nanoseconds> Spin() const noexcept { return spin_; }
+
+private:
+
+    TimerDuration duration_{ 0u };
+    std::optional<std::chrono::steady_clock::time_point> time_point_{};
+    std::optional<std::chrono::nanoseconds> slack_{};
+    std::optional<std::chrono::nanoseconds> spin_{};
+};
+
+
+// TimerSpec: One timer of a ScheduleTimers batch.
+struct TimerSpec
+{
+    uint64_t timer_id;
+    TimerDeadline duration;
+};
+
+
+// CatchUpPolicy: How a periodic timer handles ticks it missed (the previous callback, or other timers, kept the thread busy
+// past one or more further ticks).
+// - Burst:    Every missed tick is delivered, back to back, until the timer is back on schedule.
+// - Coalesce: The missed ticks collapse into a single invocation now; the next one is due at the next tick on the grid.
+// - Skip:     The late tick and the missed ones are dropped; the next invocation is at the next tick on the grid.
+enum class CatchUpPolicy
+{
+    Burst,
+    Coalesce,
+    Skip
+};
+
+
+// ShutdownPolicy: What Scheduler::Shutdown() (and the destructor) does with the timers still pending.
+// - CancelAll:          Every pending timer is dropped; only callbacks already running or queued to the worker pool complete.
+// - FireDueNow:         Every pending one-shot timer fires right away, ahead of its deadline (e.g., to flush batched work);
+//                       periodic timers are dropped.
+// - DrainUntilDeadline: One-shot timers due before the shutdown deadline fire on time; the others, and periodic timers,
+//                       are dropped.
+enum class ShutdownPolicy
+{
+    CancelAll,
+    FireDueNow,
+    DrainUntilDeadline
+};
+
+
+// CallbackErrorPolicy: What a Scheduler does when a timer callback throws. In every case the exception stops at the
+// callback: the timer is settled as if the callback had returned (a periodic timer keeps ticking), the service thread keeps
+// running, and SchedulerStats::callback_errors counts it.
+// - Log:       Reports it to the event sink (SchedulerEventKind::CallbackThrew; see SchedulerOptions::event_sink).
+// - Handler:   Calls SchedulerOptions::callback_error_handler (Log if there is none).
+// - Terminate: Logs and flushes the event sink, then calls std::terminate() (fail fast).
+// Callbacks scheduled with ScheduleTimerCompletion() or Spawn() hand their exceptions to the caller instead.
+enum class CallbackErrorPolicy
+{
+    Log,
+    Handler,
+    Terminate
+};
+
+// CallbackErrorHandler: Called with the timer id and the exception of a throwing callback (CallbackErrorPolicy::Handler).
+// Runs on the thread that ran the callback, right after it threw.
+using CallbackErrorHandler = std::function<void(uint64_t timer_id, std::exception_ptr error)>;
+
+
+// ShutdownReport: The outcome of Scheduler::Shutdown().
+// - dropped:   Timers that never fired (dropped by the policy, or still pending at the deadline), and expired callbacks still
+//              queued to the worker pool at the deadline.
+// - fired:     Callbacks started during the shutdown (including those in flight).
+// - in_flight: Callbacks still running at the deadline. Their threads were detached and exit once the callbacks return;
+//              such a callback must not use the Scheduler any more.
+// - timed_out: The deadline passed before every callback had completed.
+struct ShutdownReport
+{
+    uint64_t dropped{ 0 };
+    uint64_t fired{ 0 };
+    uint64_t in_flight{ 0 };
+    bool timed_out{ false };
+};
+
+
+// SchedulerOptions: Construction-time configuration of a Scheduler.
+struct SchedulerOptions
+{
+    // engine: The timer engine backing ScheduleTimer.
+    TimerEngine engine{ TimerEngine::AsioTimer };
+
+    // wheel_tick: Resolution of the timing wheel (TimerEngine::TimingWheel only); may be below a millisecond.
+    std::chrono::nanoseconds wheel_tick{ std::chrono::milliseconds(1) };
+
+    // worker_threads: Number of threads running io_service_ (at least 1).
+    // - With more than one, expired callbacks run concurrently on the pool, except that callbacks with the same affinity key
+    //   (the timer_id, or the instance for member-function timers) are serialized on the same strand.
+    // - On an external io_context (see Scheduler(io_context, options)) no thread is started: set it to more than one if the
+    //   caller runs the io_context on several threads, so callbacks are spread over them the same way.
+    std::size_t worker_threads{ 1 };
+
+    // callback_strands: Size of the strand pool that affinity keys are hashed onto (worker_threads > 1 only).
+    std::size_t callback_strands{ 64 };
+
+    // submission_queue_capacity: Ring slots of the lock-free submission queue in front of the timer engine (rounded up to a
+    // power of two). A burst larger than the ring still succeeds, through a slower overflow list that allocates.
+    // (0: 1024 with the Scheduler's own threads; 64 on an external io_context, where many Schedulers may share one event
+    // loop and each is typically lightly loaded.)
+    std::size_t submission_queue_capacity{ 0 };
+
+    // latency_histograms: Record the lateness and run time of every callback (see SchedulerStats). Costs two clock reads and
+    // a few relaxed atomic increments per callback.
+    bool latency_histograms{ true };
+
+    // timer_slack: How late a timer may fire so that nearby expiries share one wakeup (like Linux timerslack). Expiries are
+    // rounded up to a grid (the largest power of two nanoseconds not above the slack, counted from the Scheduler's start),
+    // so the timers due within one cell of the grid expire together and their callbacks run as one batch, in deadline
+    // order. Timers closer
+    // together than a cell may still fall on both sides of a cell boundary, and take two wakeups. Zero (the default) keeps
+    // every expiry exact.
+    // - A timer's own slack (TimerDeadline::WithSlack()) takes precedence. Periodic timers stay on their drift-free grid;
+    //   only each tick's wakeup is rounded.
+    std::chrono::nanoseconds timer_slack{ 0 };
+
+    // adaptive_slack: Shrink the coalescing window toward zero under low load (few timers armed per window, where merging
+    // saves little), and use the full slack once enough timers are armed per window to share wakeups.
+    bool adaptive_slack{ true };
+
+    // precision_spin: Precision mode's pre-wake margin (zero, the default, turns it off). The engine wakes up this much before
+    // each deadline, then the thread that runs the callback spins on steady_clock until the deadline, so callbacks start
+    // within a few microseconds of it instead of after the reactor's wakeup latency.
+    // - A timer's own margin (TimerDeadline::WithSpin()) takes precedence, so precision mode can be limited to selected timers.
+    // - Spinning occupies the callback thread for up to the margin: with one worker thread, other timers wait meanwhile. Use a
+    //   dedicated Scheduler for precise timers, or worker_threads > 1.
+    // - Tune the margin to the wakeup latency of the host: SchedulerStats::precision_lateness shows the lateness achieved,
+    //   spin_time the CPU time spent per timer. With TimerEngine::TimingWheel, keep wheel_tick below the margin.
+    std::chrono::nanoseconds precision_spin{ 0 };
+
+    // callback_error_policy, callback_error_handler: What to do when a callback throws (see CallbackErrorPolicy).
+    CallbackErrorPolicy callback_error_policy{ CallbackErrorPolicy::Log };
+    CallbackErrorHandler callback_error_handler{};
+
+    // event_sink: Where the Scheduler reports its errors (see SchedulerEvent). Null: DefaultEventSink(), an AsyncLogSink that
+    // writes to std::cerr from a background thread, rate limited. Pass an AsyncLogSink with other options (e.g., silenced
+    // kinds), or an implementation of your own.
+    std::shared_ptr<SchedulerEventSink> event_sink{};
+
+    // timer_store: The persistent timer store, for SchedulePersistent() (off unless timer_store.path is set). Its pending
+    // timers are reloaded when the Scheduler is constructed (see TimerStoreOptions).
+    TimerStoreOptions timer_store{};
+
+    // shutdown_policy, shutdown_timeout: How the destructor shuts the Scheduler down, unless Shutdown() was called before
+    // (see Scheduler::Shutdown()). The destructor returns within shutdown_timeout.
+    ShutdownPolicy shutdown_policy{ ShutdownPolicy::CancelAll };
+    std::chrono::nanoseconds shutdown_timeout{ std::chrono::seconds(5) };
+};
+
+
+// SchedulerStats: A snapshot of a Scheduler's instrumentation (see Scheduler::Stats()).
+// Each counter is read atomically while the Scheduler keeps running, so counters may be a few events apart from each other.
+struct SchedulerStats
+{
+    // active_timers:     Timers pending in the engine (one-shot and periodic), as of the engine's last update.
+    // fired:             Callback invocations (every tick of a periodic timer counts).
+    // cancelled:         Pending timers removed by CancelTimer/CancelTimers, or replaced by a new timer with the same id.
+    // suppressed:        Debounce/Throttle calls whose callback never ran, because a later call with the same key took its place.
+    // queue_depth:       Submissions (schedule, cancel, reschedule) queued to the timer engine but not applied yet.
+    // pending_callbacks: Expired callbacks posted to the worker pool that have not started yet (worker_threads > 1 only).
+    // wakeups:           Distinct expiry instants the engine woke up for (TimingWheel: wheel timer wakeups; AsioTimer: expiries
+    //                    at a new time point, as timers sharing one are fired by the same reactor wakeup). See timer_slack.
+    // callback_errors:   Callback invocations that threw (see CallbackErrorPolicy).
+    uint64_t active_timers{ 0 };
+    uint64_t fired{ 0 };
+    uint64_t cancelled{ 0 };
+    uint64_t suppressed{ 0 };
+    uint64_t queue_depth{ 0 };
+    uint64_t pending_callbacks{ 0 };
+    uint64_t wakeups{ 0 };
+    uint64_t callback_errors{ 0 };
+
+    // submissions: The submission queue's contention counters (see Scheduler::SubmissionStats()).
+    SubmissionQueueStats submissions{};
+
+    // lateness:         Callback start time minus the timer's deadline (how late timers fire).
+    // callback_runtime: How long callbacks run.
+    // Both are empty when SchedulerOptions::latency_histograms is false.
+    LatencyHistogramSnapshot lateness{};
+    LatencyHistogramSnapshot callback_runtime{};
+
+    // precision_lateness: Lateness of the timers fired in precision mode (see SchedulerOptions::precision_spin).
+    // spin_time:          How long the thread spun before each of them (zero: it woke up after the deadline; raise the margin).
+    // Both are empty when SchedulerOptions::latency_histograms is false.
+    LatencyHistogramSnapshot precision_lateness{};
+    LatencyHistogramSnapshot spin_time{};
+};
 
 
 // Scheduler for timer management.
-// Callbacks execute on a dedicated thread (io_service thread). See Boost Asio threading guidelines:
+// Callbacks execute on a dedicated thread (io_service thread), or on a pool of threads (SchedulerOptions::worker_threads), or
+// on the threads that run a caller-supplied io_context (see Scheduler(io_context, options)).
+// See Boost Asio threading guidelines:
 // https://www.boost.org/doc/libs/1_84_0/doc/html/boost_asio/overview/core/threads.html
 
 class Scheduler final
@@ -45,120 +370,2316 @@ public:
     //
     // - Starts the io_service_ using a dedicated thread (io_service_thread_).
     //   - The io_service_ is responsible for managing asynchronous operations within the Scheduler.
-    // - Creates a io_service::work object (io_service_work_) to ensure the io_service_ keeps running until explicitly stopped.
+    // - Creates a io_service::work object (io_service_work_) to ensure the io_service_ keeps running until it is shut down.
     //
     // Throws:
     //   - Any standard exceptions that might occur during thread creation or io_service_ initialization.
-    Scheduler() : io_service_(), io_service_work_(io_service_), io_service_thread_([this] { Service(); }) // (Runs the function Service() asynchronously)
+    Scheduler() : Scheduler(SchedulerOptions{})
+    {
+    }
+
+    // Constructor (options)
+    //
+    // - Same as the default constructor, with the timer engine and its parameters selected by `options`.
+    // - With `options.worker_threads` > 1, starts the additional threads (worker_threads_) on the same io_service_.
+    // - With `options.timer_store`, opens the store and reloads its pending timers (see SchedulePersistent()).
+    //
+    // Throws:
+    //   - As the default constructor.
+    //   - std::system_error or std::runtime_error if the timer store cannot be opened; std::invalid_argument if it has no
+    //     handler.
+    explicit Scheduler(const SchedulerOptions& options) : Scheduler(options, std::make_shared<boost::asio::io_service>(), nullptr, nullptr)
+    {
+    }
+
+    // Constructor (io_context, options)
+    //
+    // - Attaches the Scheduler to a caller-supplied `io_context` and starts no thread: timers, and callbacks, run on
+    //   whichever threads the caller runs the io_context on, so many Schedulers can share one event loop.
+    // - The Scheduler adds no work guard: like any other I/O object, it keeps io_context.run() busy only while timers are pending.
+    // - `io_context` must outlive the Scheduler. Handlers it still holds when the Scheduler is destroyed do nothing when
+    //   they run (see Shutdown()).
+    explicit Scheduler(boost::asio::io_context& io_context, const SchedulerOptions& options = SchedulerOptions{}) :
+        Scheduler(options, nullptr, &io_context, nullptr)
+    {
+    }
+
+    // Constructor (io_context, handler_memory, options)
+    //
+    // As Scheduler(io_context, options), but the operations Asio allocates for the Scheduler's handlers come from
+    // `handler_memory` instead of the heap (as with the Scheduler's own io_service; see Pooled()).
+    // - `handler_memory` must outlive `io_context`: Asio frees some of them (e.g., strand invokers) only when the io_context
+    //   is destroyed. E.g., an owner that holds both declares the pool first (see ShardedScheduler).
+    // - Several Schedulers may share one pool.
+    Scheduler(boost::asio::io_context& io_context, HandlerMemoryPool& handler_memory, const SchedulerOptions& options = SchedulerOptions{}) :
+        Scheduler(options, nullptr, &io_context, &handler_memory)
     {
     }
 
     // Destructor
     //
-    // - Gracefully stops the io_service_ by calling `stop()`.
-    //   - This ensures any pending asynchronous operations are completed before the scheduler is destroyed.
-    // - Waits for the dedicated io_service_ thread to finish execution using `join()`.
-    // - Catches and logs any potential exceptions that occur during the stopping or joining process.
+    // - Shuts the Scheduler down with SchedulerOptions::shutdown_policy, unless Shutdown() was called before, and so
+    //   returns within SchedulerOptions::shutdown_timeout (see Shutdown()).
+    // - Catches and reports any potential exceptions that occur during the shutdown (see SchedulerOptions::event_sink).
     ~Scheduler()
     {
-        try { 
-            io_service_.stop();
+        try {
+            Shutdown(options_.shutdown_policy, options_.shutdown_timeout);
         } catch (const std::exception& e) {
-            std::cerr << "error stopping io_service_: " << e.what() << std::endl;
+            Report(SchedulerEventKind::ShutdownFailed, std::nullopt, e);
+        }
+
+        while (submissions_.Drain([this](const Submission& submission) { DiscardSubmission(submission); })) {
+        }
+
+        // A callback still running (on a detached thread, or on a thread of the caller's io_context) may belong to one of the
+        // remaining nodes; they are left to runtime_ (whose pools are freed once the last handler is gone) rather than
+        // destroyed under it.
+        if (callbacks_in_flight_) {
+            return;
         }
 
-        // No need for io_service_thread_.join() as jthread handles that automatically.
+        // Released while io_service_ is still alive; their pending handlers do nothing (see GuardedHandler), and are discarded
+        // with io_service_ or run by the caller's io_context.
+        while (TimingWheelHook* hook = asio_nodes_.Front()) {
+            hook->Unlink();
+            DestroyNode(static_cast<TimerNode*>(hook));
+        }
+        if (wheel_) {
+            wheel_->Clear([this](TimerNode* node) { DestroyNode(node); });
+        }
     }
 
     // (1) ScheduleTimer(timer_id, duration, callback, callback_args...)
     //
     // Schedules a timer with the most flexible option, accepting any callable object (lambda, functor, etc.) as the callback.
-    // - `timer_id`: A unique identifier for the timer.
-    // - `duration`: The duration (in milliseconds) until the timer expires.
-    // - `callback`: The callable object to be invoked when the timer expires.
-    // - `callback_args...`: Optional arguments to be passed to the callback.
+    // - `timer_id`: A unique identifier for the timer. Scheduling an id that is still pending replaces (cancels) the pending timer.
+    // - `duration`: When the timer expires: milliseconds from now (uint32_t), any std::chrono::duration from now, or an absolute
+    //   std::chrono::steady_clock::time_point (see TimerDeadline), optionally with a slack (TimerDeadline::WithSlack()).
+    // - `callback`: The callable object to be invoked when the timer expires (may be move-only, e.g., a lambda owning a std::unique_ptr).
+    // - `callback_args...`: Optional arguments to be passed to the callback (may be move-only, e.g., std::unique_ptr).
     //
-    // Creates a shared pointer to a `boost::asio::deadline_timer`, sets up an asynchronous wait using the provided callback,
-    // and handles potential errors during setup.
+    // Creates a timer node holding the bound callback and queues its insertion to the thread that owns the timer index and the
+    // selected engine (see submissions_), and handles potential errors during setup.
+    // - The callback and its arguments are perfectly forwarded: moved (rvalues) or copied (lvalues) into the node exactly once.
+    // - The timer fires once, so the arguments are moved into the callback: it may take them by value or by rvalue reference.
     template <typename Callback, typename... Args>
-    void ScheduleTimer(const uint64_t timer_id, const uint32_t duration, const Callback& callback, Args... callback_args)
+        requires (!std::is_member_function_pointer_v<std::decay_t<Callback>>)
+    void ScheduleTimer(const uint64_t timer_id, const TimerDeadline duration, Callback&& callback, Args&&... callback_args)
     {
-        // Create a shared pointer to a boost::asio::deadline_timer:
-        const auto timer = std::make_shared<boost::asio::deadline_timer>(io_service_, boost::posix_time::milliseconds(duration));
-
-        try {
-            // Set up asynchronous wait on the timer, invoking the provided callback when the timer expires:
-            timer->async_wait([timer_id, timer, callback, callback_args...](const boost::system::error_code& e) {
-                if (e) {
-                    // Handle error
-                    std::cerr << "error waiting on timer (id = " << timer_id << "): " << e.message() << std::endl;
-                } else {
-                    // Call the callback with the captured arguments
-                    callback(timer_id, callback_args...);
-                }
-                });
-        } catch (const std::exception& e) {
-            std::cerr << "error scheduling timer (id = " << timer_id << "): " << e.what() << std::endl;
-        }
+        ScheduleTimerImpl<true>(timer_id, duration, {}, {}, timer_id, std::forward<Callback>(callback), std::forward<Args>(callback_args)...);
     }
 
     // (2) ScheduleTimer(timer_id, duration, member_function, instance, member_function_args...)
     //
     // Schedules a timer that invokes a member function of an object.
     // - `timer_id`: A unique identifier for the timer.
-    // - `duration`: The duration (in milliseconds) until the timer expires.
+    // - `duration`: When the timer expires (as in (1)).
     // - `member_function`: A pointer to the member function to be invoked.
     // - `instance`: A pointer to the object on which to invoke the member function.
     // - `member_function_args...`: Optional arguments to be passed to the member function.
     //
-    // Creates a lambda callback capturing the member function and instance, then delegates to the generic `ScheduleTimer` overload
-    // with the lambda and any additional arguments.
+    // Creates a lambda callback capturing the member function and instance, then schedules it like the generic `ScheduleTimer`
+    // overload, with the instance as the strand affinity key (callbacks on the same object never run concurrently).
     template <typename Callback, typename T, typename... Args>
-    void ScheduleTimer(const uint64_t timer_id, const uint32_t duration, const Callback& member_function, T* instance, Args... member_function_args)
+        requires std::is_member_function_pointer_v<std::decay_t<Callback>>
+    void ScheduleTimer(const uint64_t timer_id, const TimerDeadline duration, const Callback member_function, T* instance, Args&&... member_function_args)
     {
         // The lambda callback shapes the *form* of the callback.
         // (Captures the member_function and instance, effectively binding them together.)
-        auto callback = [member_function, instance](uint64_t timer_id, Args... lambda_args) {
-            (instance->*member_function)(timer_id, std::forward<Args>(lambda_args)...);
+        auto callback = [member_function, instance](uint64_t timer_id, auto&&... lambda_args) {
+            (instance->*member_function)(timer_id, std::forward<decltype(lambda_args)>(lambda_args)...);
             };
 
         // Schedules the timer using the lambda callback and forwards any additional arguments (member_function_args).
-        ScheduleTimer(timer_id, duration, callback, std::forward<Args>(member_function_args)...); // <-- DELEGATE TO (1)
+        ScheduleTimerImpl<true>(timer_id, duration, {}, {}, reinterpret_cast<uintptr_t>(instance), std::move(callback), std::forward<Args>(member_function_args)...);
     }
 
-private:
+    // (1c) ScheduleTimerCompletion(timer_id, duration, callback, callback_args...)
+    //
+    // Same as (1), returning a TimerCompletion handle that tells whether and when the timer fired, and carries the callback's
+    // return value (or exception): e.g., `scheduler.ScheduleTimerCompletion(1, 100, Probe).Get()` returns Probe's result.
+    // - The handle and the callback share one small, reference-counted state with an atomic status word (see
+    //   TimerCompletionState), allocated with the timer: no std::promise, mutex or condition variable.
+    // - If the timer is cancelled, replaced, dropped by Shutdown(), or cannot be scheduled, the handle reports
+    //   TimerStatus::Cancelled.
+    template <typename Callback, typename... Args>
+        requires (!std::is_member_function_pointer_v<std::decay_t<Callback>>)
+    auto ScheduleTimerCompletion(const uint64_t timer_id, const TimerDeadline duration, Callback&& callback, Args&&... callback_args)
+    {
+        return ScheduleCompletionImpl(timer_id, duration, timer_id, std::forward<Callback>(callback), std::forward<Args>(callback_args)...);
+    }
 
-    // Service()
+    // (2c) ScheduleTimerCompletion(timer_id, duration, member_function, instance, member_function_args...)
     //
-    // - Runs in the context of a dedicated thread (io_service_thread_).
-    // - Starts the Boost Asio io_service_ event loop, which is responsible for executing all scheduled asynchronous operations.
-    // - This function blocks until the io_service_ is explicitly stopped or an error occurs.
-    // - Catches and logs any exceptions that occur during the io_service_ execution.
+    // Same as (2), returning a TimerCompletion handle (as in (1c)).
+    template <typename Callback, typename T, typename... Args>
+        requires std::is_member_function_pointer_v<std::decay_t<Callback>>
+    auto ScheduleTimerCompletion(const uint64_t timer_id, const TimerDeadline duration, const Callback member_function, T* instance, Args&&... member_function_args)
+    {
+        auto callback = [member_function, instance](uint64_t timer_id, auto&&... lambda_args) {
+            return (instance->*member_function)(timer_id, std::forward<decltype(lambda_args)>(lambda_args)...);
+            };
+
+        return ScheduleCompletionImpl(timer_id, duration, reinterpret_cast<uintptr_t>(instance), std::move(callback), std::forward<Args>(member_function_args)...);
+    }
+
+    // (3) SchedulePeriodic(timer_id, period, catch_up, callback, callback_args...)
     //
-    // Note: This function should not be called directly.
-    void Service()
+    // Schedules a recurring timer that invokes `callback(timer_id, callback_args...)` every `period` until it is cancelled
+    // (CancelTimer) or replaced (a ScheduleTimer/SchedulePeriodic call with the same id).
+    // - `period`: Milliseconds (uint32_t) or any std::chrono::duration; at least 1 nanosecond.
+    // - One timer node is re-used for every period; nothing is allocated per tick.
+    // - Drift-free: the n-th expiry is due at start + n * period (absolute-time stepping), regardless of callback run time.
+    // - `catch_up`: What to do with ticks missed because the thread was busy (see CatchUpPolicy).
+    // - The callback and its arguments are forwarded into the node once; every tick invokes the callback with the stored
+    //   arguments as lvalues. They must be copyable (with a worker pool, each tick's invocation is posted with a copy).
+    template <typename Callback, typename... Args>
+        requires (!std::is_member_function_pointer_v<std::decay_t<Callback>>)
+    void SchedulePeriodic(const uint64_t timer_id, const TimerDuration period, const CatchUpPolicy catch_up, Callback&& callback, Args&&... callback_args)
+    {
+        const auto interval = std::max(period.Get(), std::chrono::nanoseconds(1));
+        ScheduleTimerImpl<false>(timer_id, std::chrono::steady_clock::now() + interval, interval, catch_up, timer_id, std::forward<Callback>(callback), std::forward<Args>(callback_args)...);
+    }
+
+    // (4) SchedulePeriodic(timer_id, period, catch_up, member_function, instance, member_function_args...)
+    //
+    // Same as (3), invoking a member function of an object (with the instance as the strand affinity key, like (2)).
+    template <typename Callback, typename T, typename... Args>
+        requires std::is_member_function_pointer_v<std::decay_t<Callback>>
+    void SchedulePeriodic(const uint64_t timer_id, const TimerDuration period, const CatchUpPolicy catch_up, const Callback member_function, T* instance, Args&&... member_function_args)
+    {
+        auto callback = [member_function, instance](uint64_t timer_id, auto&&... lambda_args) {
+            (instance->*member_function)(timer_id, std::forward<decltype(lambda_args)>(lambda_args)...);
+            };
+
+        const auto interval = std::max(period.Get(), std::chrono::nanoseconds(1));
+        ScheduleTimerImpl<false>(timer_id, std::chrono::steady_clock::now() + interval, interval, catch_up, reinterpret_cast<uintptr_t>(instance), std::move(callback), std::forward<Args>(member_function_args)...);
+    }
+
+    // (5) SchedulePeriodic(timer_id, period, callback_or_member_function, args...)
+    //
+    // Same as (3) or (4), with the default catch-up policy (CatchUpPolicy::Coalesce).
+    template <typename Callback, typename... Args>
+        requires (!std::is_same_v<std::decay_t<Callback>, CatchUpPolicy>)
+    void SchedulePeriodic(const uint64_t timer_id, const TimerDuration period, Callback&& callback, Args&&... args)
+    {
+        SchedulePeriodic(timer_id, period, CatchUpPolicy::Coalesce, std::forward<Callback>(callback), std::forward<Args>(args)...);
+    }
+
+    // (6) ScheduleTimers(specs, callback, callback_args...)
+    //
+    // Schedules a batch of timers that share one callback, e.g., re-arming every connection's keepalive at once.
+    // - `specs`: The timer ids and their deadlines (as in ScheduleTimer). Each timer is independent afterwards: it can be
+    //   cancelled or rescheduled by id, and an id that is still pending is replaced.
+    // - `callback`, `callback_args...`: As in (1); invoked as callback(timer_id, callback_args...) for each timer. Each timer
+    //   holds its own copy (so they must be copyable), which is moved into the callback when the timer fires.
+    //
+    // The whole batch reaches the timer engine as a single submission, instead of one per timer.
+    template <typename Callback, typename... Args>
+        requires (!std::is_member_function_pointer_v<std::decay_t<Callback>>)
+    void ScheduleTimers(const std::span<const TimerSpec> specs, const Callback& callback, const Args&... callback_args)
+    {
+        ScheduleTimersImpl(specs, std::nullopt, callback, callback_args...);
+    }
+
+    // (7) ScheduleTimers(specs, member_function, instance, member_function_args...)
+    //
+    // Same as (6), invoking a member function of an object (with the instance as the strand affinity key, like (2)).
+    template <typename Callback, typename T, typename... Args>
+        requires std::is_member_function_pointer_v<std::decay_t<Callback>>
+    void ScheduleTimers(const std::span<const TimerSpec> specs, const Callback member_function, T* instance, const Args&... member_function_args)
+    {
+        auto callback = [member_function, instance](uint64_t timer_id, auto&&... lambda_args) {
+            (instance->*member_function)(timer_id, std::forward<decltype(lambda_args)>(lambda_args)...);
+            };
+
+        ScheduleTimersImpl(specs, reinterpret_cast<uintptr_t>(instance), callback, member_function_args...);
+    }
+
+    // (8) Debounce(timer_id, delay, callback, callback_args...)
+    //
+    // Runs `callback(timer_id, callback_args...)` once `delay` has passed without another Debounce call for `timer_id`:
+    // each call replaces the pending callback with its own and pushes the deadline back to `delay` from now.
+    // - `delay`: Milliseconds (uint32_t) or any std::chrono::duration.
+    // - Upsert: the pending timer node is updated in place (see Upsert()); the call's own pooled node only carries the
+    //   callback to engine_strand_ (no heap allocation once the node pool has grown, for callbacks that fit TimerCallback).
+    // - Calls whose callback was replaced before it ran are counted in SchedulerStats::suppressed.
+    // - A pending timer with the same id that was not scheduled by Debounce() is replaced, as by ScheduleTimer().
+    template <typename Callback, typename... Args>
+        requires (!std::is_member_function_pointer_v<std::decay_t<Callback>>)
+    void Debounce(const uint64_t timer_id, const TimerDuration delay, Callback&& callback, Args&&... callback_args)
+    {
+        ScheduleKeyedImpl(TimerMode::Debounce, timer_id, std::chrono::steady_clock::now() + delay.Get(), {}, timer_id,
+            std::forward<Callback>(callback), std::forward<Args>(callback_args)...);
+    }
+
+    // (9) Debounce(timer_id, delay, member_function, instance, member_function_args...)
+    //
+    // Same as (8), invoking a member function of an object (with the instance as the strand affinity key, like (2)).
+    template <typename Callback, typename T, typename... Args>
+        requires std::is_member_function_pointer_v<std::decay_t<Callback>>
+    void Debounce(const uint64_t timer_id, const TimerDuration delay, const Callback member_function, T* instance, Args&&... member_function_args)
+    {
+        auto callback = [member_function, instance](uint64_t timer_id, auto&&... lambda_args) {
+            (instance->*member_function)(timer_id, std::forward<decltype(lambda_args)>(lambda_args)...);
+            };
+
+        ScheduleKeyedImpl(TimerMode::Debounce, timer_id, std::chrono::steady_clock::now() + delay.Get(), {}, reinterpret_cast<uintptr_t>(instance),
+            std::move(callback), std::forward<Args>(member_function_args)...);
+    }
+
+    // (10) Throttle(timer_id, interval, callback, callback_args...)
+    //
+    // Runs `callback(timer_id, callback_args...)` at most once per `interval` for `timer_id`, on both edges:
+    // - Leading: a call outside a window runs right away, and opens a window of `interval`.
+    // - Trailing: calls within the window replace each other; the latest runs when the window ends, and opens the next one.
+    //   A window that ends with no call closes the throttle.
+    // - `interval`: Milliseconds (uint32_t) or any std::chrono::duration; at least 1 nanosecond.
+    // - Upsert, and SchedulerStats::suppressed, as in (8). A pending timer with the same id that was not scheduled by
+    //   Throttle() is replaced.
+    template <typename Callback, typename... Args>
+        requires (!std::is_member_function_pointer_v<std::decay_t<Callback>>)
+    void Throttle(const uint64_t timer_id, const TimerDuration interval, Callback&& callback, Args&&... callback_args)
+    {
+        ScheduleKeyedImpl(TimerMode::Throttle, timer_id, std::chrono::steady_clock::now(), std::max(interval.Get(), std::chrono::nanoseconds(1)),
+            timer_id, std::forward<Callback>(callback), std::forward<Args>(callback_args)...);
+    }
+
+    // (11) Throttle(timer_id, interval, member_function, instance, member_function_args...)
+    //
+    // Same as (10), invoking a member function of an object (with the instance as the strand affinity key, like (2)).
+    template <typename Callback, typename T, typename... Args>
+        requires std::is_member_function_pointer_v<std::decay_t<Callback>>
+    void Throttle(const uint64_t timer_id, const TimerDuration interval, const Callback member_function, T* instance, Args&&... member_function_args)
+    {
+        auto callback = [member_function, instance](uint64_t timer_id, auto&&... lambda_args) {
+            (instance->*member_function)(timer_id, std::forward<decltype(lambda_args)>(lambda_args)...);
+            };
+
+        ScheduleKeyedImpl(TimerMode::Throttle, timer_id, std::chrono::steady_clock::now(), std::max(interval.Get(), std::chrono::nanoseconds(1)),
+            reinterpret_cast<uintptr_t>(instance), std::move(callback), std::forward<Args>(member_function_args)...);
+    }
+
+    // (12) ScheduleIdleTimeout(timer_id, timeout, callback, callback_args...)
+    //
+    // Schedules a one-shot timer that fires once `timeout` has passed with no activity, and returns an IdleTimeout handle to
+    // record activity with (e.g., `timeout.Touch()` on every packet of a connection).
+    // - Touch() is a relaxed store of the time into a state shared with the timer node: the timer is not cancelled,
+    //   re-scheduled or re-allocated, and the engine is not involved. When the timer's deadline comes, the engine compares
+    //   it with the last activity and, if there was any, re-arms the same node for the rest of the timeout (lazy re-arming):
+    //   one engine operation per `timeout` at most, however often the timeout is touched.
+    // - `timeout`: Milliseconds (uint32_t) or any std::chrono::duration; at least 1 nanosecond.
+    // - The timer can be cancelled, rescheduled or replaced by its id like any other; the handle then has no effect.
+    // - If the timer cannot be scheduled, the failure is reported (SchedulerEventKind::ScheduleFailed) and touching the handle
+    //   has no effect.
+    template <typename Callback, typename... Args>
+        requires (!std::is_member_function_pointer_v<std::decay_t<Callback>>)
+    IdleTimeout ScheduleIdleTimeout(const uint64_t timer_id, const TimerDuration timeout, Callback&& callback, Args&&... callback_args)
+    {
+        return ScheduleIdleImpl(timer_id, timeout, timer_id, std::forward<Callback>(callback), std::forward<Args>(callback_args)...);
+    }
+
+    // (13) ScheduleIdleTimeout(timer_id, timeout, member_function, instance, member_function_args...)
+    //
+    // Same as (12), invoking a member function of an object (with the instance as the strand affinity key, like (2)).
+    template <typename Callback, typename T, typename... Args>
+        requires std::is_member_function_pointer_v<std::decay_t<Callback>>
+    IdleTimeout ScheduleIdleTimeout(const uint64_t timer_id, const TimerDuration timeout, const Callback member_function, T* instance, Args&&... member_function_args)
+    {
+        auto callback = [member_function, instance](uint64_t timer_id, auto&&... lambda_args) {
+            (instance->*member_function)(timer_id, std::forward<decltype(lambda_args)>(lambda_args)...);
+            };
+
+        return ScheduleIdleImpl(timer_id, timeout, reinterpret_cast<uintptr_t>(instance), std::move(callback), std::forward<Args>(member_function_args)...);
+    }
+
+    // (14) SchedulePersistent(timer_id, duration, payload)
+    //
+    // Schedules a one-shot timer that outlives the process: its id, absolute deadline and `payload` are appended to the timer
+    // store (SchedulerOptions::timer_store), and it fires as `handler(timer_id, payload)` (TimerStoreOptions::handler).
+    // - `duration`: When the timer expires (as in (1)). The store keeps it as system_clock time, so after a restart the timer
+    //   fires at the same wall-clock time (or, if that has passed, as TimerStoreOptions::overdue says).
+    // - `payload`: Any bytes (e.g., a serialized request to retry); copied into the store, not kept in memory.
+    // - The record is erased once the handler has returned: a timer whose handler threw, or was running when the process
+    //   ended, fires again after the restart (at least once).
+    // - Cancelling, replacing or rescheduling the timer (by its id, like any other) is recorded in the store. Timers still
+    //   pending when the Scheduler shuts down stay in the store, whatever the ShutdownPolicy (but FireDueNow, which fires
+    //   them).
+    // - Without a timer store, the call is reported (SchedulerEventKind::ScheduleFailed) and ignored.
+    void SchedulePersistent(const uint64_t timer_id, const TimerDeadline duration, const std::span<const std::byte> payload)
     {
+        uint64_t sequence = 0;
         try {
-            io_service_.run(); // (Blocking)
+            if (!runtime_->timer_store_) {
+                throw std::logic_error("no timer store (see SchedulerOptions::timer_store)");
+            }
+
+            const auto deadline = duration.Resolve();
+            NodePtr node = MakeNode();
+            node->timer_id_ = timer_id;
+            node->affinity_key_ = timer_id;
+            node->slack_ = duration.Slack();
+            node->spin_ = duration.Spin();
+
+            sequence = runtime_->timer_store_->Put(timer_id, ToSystemTime(deadline), payload);
+            node->store_sequence_ = sequence;
+            node->callback_ = PersistentCallback(timer_id, sequence);
+
+            Submit({ Submission::Kind::Schedule, timer_id, deadline, node.get() });
+            node.release();
         } catch (const std::exception& e) {
-            std::cerr << "exception in service thread: " << e.what() << std::endl;
+            if (sequence != 0) {
+                EraseStored(*runtime_, timer_id, sequence); // (Not scheduled: not to be reloaded either)
+            }
+            Report(SchedulerEventKind::ScheduleFailed, timer_id, e);
         }
     }
 
-    // io_service_: The core object from Boost Asio responsible for managing asynchronous operations within the Scheduler.
-    // - Handles the scheduling and execution of the timers.
-    // - Functions as the central event loop for the Scheduler's asynchronous activities.
-    boost::asio::io_service io_service_{};
+    // CancelTimer(timer_id)
+    //
+    // Cancels the pending timer `timer_id`; its callback will not be invoked.
+    // - Asynchronous: the cancellation is queued to engine_strand_ and ordered after any ScheduleTimer call made before it.
+    // - The timer is looked up in O(1) and removed from the engine; it is not woken with an error and nothing is logged.
+    // - Has no effect if the timer already expired or was never scheduled.
+    void CancelTimer(const uint64_t timer_id)
+    {
+        try {
+            Submit({ Submission::Kind::Cancel, timer_id });
+        } catch (const std::exception& e) {
+            Report(SchedulerEventKind::CancelFailed, timer_id, e);
+        }
+    }
 
-    // io_service_work_: A work object associated with the io_service_ to prevent it from automatically exiting.
-    // - Ensures the io_service_ event loop continues to run even when there are no pending asynchronous operations.
-    // - This keeps the Scheduler active and ready to handle new tasks as they arrive.
-    const boost::asio::io_service::work io_service_work_;
+    // RescheduleTimer(timer_id, new_duration)
+    //
+    // Moves the deadline of the pending timer `timer_id` to `new_duration`, keeping its callback and slack.
+    // - `new_duration`: As in ScheduleTimer (milliseconds, a std::chrono::duration, or an absolute time point).
+    // - Asynchronous, like CancelTimer(); a relative deadline is measured from the time of this call.
+    // - Has no effect if the timer already expired or was never scheduled.
+    void RescheduleTimer(const uint64_t timer_id, const TimerDeadline new_duration)
+    {
+        try {
+            Submit({ Submission::Kind::Reschedule, timer_id, new_duration.Resolve() });
+        } catch (const std::exception& e) {
+            Report(SchedulerEventKind::RescheduleFailed, timer_id, e);
+        }
+    }
 
-    // io_service_thread_: Thread for running io_service_ event loop, separate from the Scheduler's creation thread.
-    // - This prevents blocking of the creating thread and ensures responsiveness.
-    // - It enables concurrent handling of asynchronous operations alongside other tasks in the program.
-    std::jthread io_service_thread_{};
+    // CancelTimers(timer_ids)
+    //
+    // Cancels a batch of pending timers (see CancelTimer). The cancellations are queued back to back and applied by the timer
+    // engine in one drain of the submission queue; nothing is allocated.
+    void CancelTimers(const std::span<const uint64_t> timer_ids)
+    {
+        try {
+            for (const uint64_t timer_id : timer_ids) {
+                Submit({ Submission::Kind::Cancel, timer_id });
+            }
+        } catch (const std::exception& e) {
+            Report(SchedulerEventKind::CancelFailed, std::nullopt, e); // (A batch)
+        }
+    }
+
+    // kSleepTimerIdBase: Timer ids from here up are reserved for SleepFor() / SleepUntil().
+    static constexpr uint64_t kSleepTimerIdBase = uint64_t{ 1 } << 63;
+
+    // SleepAwaiter: The awaitable returned by SleepFor() / SleepUntil().
+    class SleepAwaiter final
+    {
+    public:
+
+        bool await_ready() const noexcept { return false; }
+
+        // Schedules a one-shot timer that resumes the awaiting coroutine (see SleepFor()).
+        template <typename Promise>
+        void await_suspend(const std::coroutine_handle<Promise> awaiting)
+        {
+            std::coroutine_handle<> root{};
+            if constexpr (std::is_base_of_v<TaskPromiseBase, Promise>) {
+                root = awaiting.promise().root_;
+            }
+
+            Scheduler& scheduler = *scheduler_;
+            const TimerDeadline deadline = deadline_;
+            const uint64_t timer_id = scheduler.next_sleep_id_.fetch_add(1, std::memory_order_relaxed);
+            scheduler.ScheduleTimerImpl<true>(timer_id, deadline, {}, {}, timer_id, CoroutineResumer(awaiting, root));
+            // (The coroutine may be running, or destroyed, on another thread already: *this must not be touched any more)
+        }
+
+        void await_resume() const noexcept {}
+
+    private:
+
+        friend class Scheduler;
+
+        SleepAwaiter(Scheduler* scheduler, const TimerDeadline deadline) noexcept : scheduler_(scheduler), deadline_(deadline)
+        {
+        }
+
+        Scheduler* scheduler_;
+        TimerDeadline deadline_;
+    };
+
+    // SleepFor(duration)
+    //
+    // Returns an awaitable that suspends the calling coroutine for `duration` (milliseconds as uint32_t, or any
+    // std::chrono::duration, measured from the co_await): `co_await scheduler.SleepFor(std::chrono::milliseconds(100));`
+    // - The wait is an ordinary one-shot timer (with a reserved id; see kSleepTimerIdBase), so thousands of coroutines can
+    //   wait at once on the selected engine without a thread each. SchedulerOptions::timer_slack applies.
+    // - The coroutine resumes on the thread that runs callbacks: io_service_thread_, a thread of the worker pool, or one of
+    //   the caller's io_context.
+    // - Resuming allocates nothing: the timer node is pooled and the resumer is stored inline in it.
+    // - If the wait cannot be scheduled, or is dropped by Shutdown(), a Task chain started with Spawn() is destroyed (like
+    //   Asio destroys pending handlers); any other coroutine stays suspended.
+    SleepAwaiter SleepFor(const TimerDuration duration) noexcept
+    {
+        return SleepAwaiter(this, duration.Get());
+    }
+
+    // SleepUntil(time_point)
+    //
+    // Same as SleepFor(), until an absolute std::chrono::steady_clock time point.
+    SleepAwaiter SleepUntil(const std::chrono::steady_clock::time_point time_point) noexcept
+    {
+        return SleepAwaiter(this, time_point);
+    }
+
+    // Spawn(task)
+    //
+    // Starts a Task (typically one that uses SleepFor()) on the thread that runs callbacks, and returns a std::future for its
+    // result (or its exception).
+    // - The task runs detached: its frame is freed when it completes, so nothing needs to keep the future.
+    // - If the task never starts (the Scheduler shuts down first), or is dropped while it sleeps, the future reports
+    //   std::future_errc::broken_promise.
+    template <typename T>
+    std::future<T> Spawn(Task<T> task)
+    {
+        std::promise<T> promise{};
+        std::future<T> future = promise.get_future();
+
+        try {
+            // (Resumed on io_service_; destroyed with the posted handler if it never runs)
+            const std::coroutine_handle<> detached = RunDetached(std::move(task), std::move(promise)).Release();
+            boost::asio::post(io_service_, Pooled(CoroutineResumer(detached, detached)));
+        } catch (const std::exception& e) {
+            Report(SchedulerEventKind::SpawnFailed, std::nullopt, e);
+        }
+        return future;
+    }
+
+    // Shutdown(policy, timeout)
+    //
+    // Stops the Scheduler, applying `policy` to the pending timers (see ShutdownPolicy), and waits at most `timeout` for the
+    // callbacks that the policy lets run. Returns what happened to the timers (see ShutdownReport).
+    // - New timers are refused from the start of the shutdown (the calls log an error); CancelTimer() keeps working, e.g.,
+    //   from callbacks that still run under DrainUntilDeadline.
+    // - Once the pending timers are settled and the last callback has returned, the service threads exit and are joined.
+    // - At the deadline, the remaining timers are dropped and the threads stopped. A thread still inside a callback is
+    //   detached (ShutdownReport::in_flight): it exits as soon as the callback returns, without touching the Scheduler, so
+    //   Shutdown() and the destructor return on time however long a callback blocks.
+    // - On an external io_context, waits until the io_context has run the Scheduler's handlers; the io_context is never
+    //   stopped. Called on a thread that runs the io_context (which cannot run them meanwhile), or while it is stopped,
+    //   Shutdown() does not wait: the pending timers are dropped.
+    // - From then on, handlers of the Scheduler that the io_service still runs return at once.
+    // - Only the first call does anything; later calls return an empty report. Must not be called from a callback.
+    ShutdownReport Shutdown(const ShutdownPolicy policy, const TimerDuration timeout)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + timeout.Get();
+        if (shutting_down_.exchange(true)) {
+            return {};
+        }
+
+        ShutdownReport report{};
+        const uint64_t fired = fired_.load(std::memory_order_relaxed);
+
+        try {
+            boost::asio::post(engine_strand_, Pooled([this, policy, deadline] { StopEngine(policy, deadline); }));
+        } catch (const std::exception& e) {
+            Report(SchedulerEventKind::EngineFailed, std::nullopt, e); // (Posting the shutdown; the timers are dropped at the deadline)
+        }
+
+        Runtime& runtime = *runtime_;
+        if (own_io_service_) {
+            std::unique_lock lock(runtime.mutex_);
+            report.timed_out = !runtime.thread_exited_.wait_until(lock, deadline, [&runtime] { return runtime.live_threads_ == 0; });
+            if (report.timed_out) {
+                io_service_.stop();
+            }
+        } else {
+            report.timed_out = !WaitForHandlers(deadline);
+        }
+
+        // From here on, a handler returns at once, and a callback that returns unwinds its handler (see GuardedHandler).
+        // Threads running Scheduler code (outside of callbacks) do not block; wait for them:
+        runtime.abandoned_.store(true);
+        while (runtime.in_handlers_.load() != 0) {
+            std::this_thread::yield();
+        }
+        report.in_flight = runtime.in_callbacks_.load();
+        callbacks_in_flight_ = report.in_flight != 0;
+
+        if (report.in_flight == 0) {
+            if (io_service_thread_.joinable()) {
+                io_service_thread_.join();
+            }
+            worker_threads_.clear();
+        } else {
+            if (io_service_thread_.joinable()) {
+                io_service_thread_.detach();
+            }
+            for (auto& thread : worker_threads_) {
+                thread.detach();
+            }
+        }
+
+        // Nothing runs Scheduler code any more: timers left in the engine, and callbacks left in the worker pool's queue,
+        // never run.
+        report.dropped = shutdown_dropped_ + index_.Size() + pending_callbacks_.load(std::memory_order_relaxed);
+        report.fired = fired_.load(std::memory_order_relaxed) - fired;
+        return report;
+    }
+
+    // SubmissionStats()
+    //
+    // Returns the counters of the submission queue that carries every ScheduleTimer/CancelTimer/RescheduleTimer call to the
+    // timer engine (see SubmissionQueueStats): how many submissions, how often producers contended for a ring slot, how
+    // often the ring overflowed, and how well submissions were batched (drains, largest_drain).
+    SubmissionQueueStats SubmissionStats() const noexcept
+    {
+        return submissions_.Stats();
+    }
+
+    // StoreStats()
+    //
+    // Returns a snapshot of the timer store's counters (see TimerStoreStats; all zero without a store).
+    TimerStoreStats StoreStats() const
+    {
+        return runtime_->timer_store_ ? runtime_->timer_store_->Stats() : TimerStoreStats{};
+    }
+
+    // FlushStore()
+    //
+    // Writes the timer store to the disk, so its timers also survive a crash of the machine, not only of the process (see
+    // TimerStore). No effect without a store.
+    //
+    // Throws:
+    //   - std::system_error if the store cannot be written.
+    void FlushStore()
+    {
+        if (runtime_->timer_store_) {
+            runtime_->timer_store_->Flush();
+        }
+    }
+
+    // Stats()
+    //
+    // Returns a snapshot of the Scheduler's counters and latency histograms (see SchedulerStats).
+    // - Lock-free and callable from any thread (including callbacks) while timers keep firing; nothing is stopped or paused.
+    SchedulerStats Stats() const noexcept
+    {
+        SchedulerStats stats{};
+        stats.active_timers = active_timers_.load(std::memory_order_relaxed);
+        stats.fired = fired_.load(std::memory_order_relaxed);
+        stats.cancelled = cancelled_.load(std::memory_order_relaxed);
+        stats.suppressed = suppressed_.load(std::memory_order_relaxed);
+        stats.pending_callbacks = pending_callbacks_.load(std::memory_order_relaxed);
+        stats.wakeups = wakeups_.load(std::memory_order_relaxed);
+        stats.callback_errors = runtime_->callback_errors_.load(std::memory_order_relaxed);
+        stats.submissions = submissions_.Stats();
+        stats.queue_depth = stats.submissions.depth;
+        stats.lateness = lateness_.Snapshot();
+        stats.callback_runtime = callback_runtime_.Snapshot();
+        stats.precision_lateness = precision_lateness_.Snapshot();
+        stats.spin_time = spin_time_.Snapshot();
+        return stats;
+    }
+
+private:
+
+    using Strand = boost::asio::strand<boost::asio::io_service::executor_type>;
+
+    // TimerMode: What a node was scheduled by.
+    // - Timer:    ScheduleTimer/SchedulePeriodic/ScheduleTimers; a new timer with the same id replaces it.
+    // - Debounce: Debounce(); a new call with the same id takes its place and pushes its deadline back (see Upsert()).
+    // - Throttle: Throttle(); a new call with the same id takes its place within the current window (see Upsert(), Expire()).
+    // - Idle:     ScheduleIdleTimeout(); pushed back lazily by the activity recorded in its IdleTimeout (see Expire()).
+    enum class TimerMode : uint8_t
+    {
+        Timer,
+        Debounce,
+        Throttle,
+        Idle
+    };
+
+    // TimerNode: A scheduled timer, shared by both engines.
+    // - The TimingWheelHook links the node into a wheel slot (TimingWheel engine) or into asio_nodes_ (AsioTimer engine).
+    // - Owned by the wheel or asio_nodes_ while pending; index_ only refers to it.
+    struct TimerNode final : TimingWheelHook
+    {
+        uint64_t timer_id_{ 0 };
+        uint64_t affinity_key_{ 0 };
+        TimerCallback callback_{};
+
+        // deadline_: When the node is due (before rounding to the engine's resolution).
+        // period_:   Zero for one-shot timers; the recurrence interval of periodic timers.
+        // catch_up_: Periodic timers only; see CatchUpPolicy.
+        std::chrono::steady_clock::time_point deadline_{};
+        std::chrono::nanoseconds period_{ 0 };
+        CatchUpPolicy catch_up_{ CatchUpPolicy::Coalesce };
+
+        // slack_: The timer's own slack (TimerDeadline::WithSlack()), or std::nullopt for SchedulerOptions::timer_slack.
+        std::optional<std::chrono::nanoseconds> slack_{};
+
+        // mode_:     How a call with the same id treats the pending node (see TimerMode).
+        // interval_: Throttle: the window during which further calls are held back; Idle: the idle timeout.
+        // activity_: Idle only; the last activity, recorded by the caller's IdleTimeout handles.
+        TimerMode mode_{ TimerMode::Timer };
+        std::chrono::nanoseconds interval_{ 0 };
+        IdleTimeout activity_{};
+
+        // store_sequence_: Persistent timers only; the timer's sequence in the timer store (zero: not persistent).
+        uint64_t store_sequence_{ 0 };
+
+        // spin_: The timer's own precision spin margin (TimerDeadline::WithSpin()), or std::nullopt for
+        //        SchedulerOptions::precision_spin.
+        std::optional<std::chrono::nanoseconds> spin_{};
+
+        // AsioTimer engine only:
+        // - asio_timer_:    The node's own Asio timer (created on first use, re-used by RescheduleTimer).
+        // - generation_:    Incremented on every (re)arm, so a wait that completed before a reschedule is recognized as stale.
+        // - pending_waits_: Outstanding async_wait handlers; the node is deleted once it is retired and the last one has run.
+        // - retired_:       The node expired or was cancelled.
+        std::optional<boost::asio::steady_timer> asio_timer_{};
+        uint32_t generation_{ 0 };
+        uint32_t pending_waits_{ 0 };
+        bool retired_{ false };
+    };
+
+    // ExpiringNode: An AsioTimer node waiting in the expiry batch, with the generation its wait completed for (see
+    // ExpireInBatch()).
+    struct ExpiringNode
+    {
+        TimerNode* node_{ nullptr };
+        uint32_t generation_{ 0 };
+    };
+
+    // Runtime: The part of the Scheduler that its service threads and its handlers share ownership of (each holds a
+    // std::shared_ptr), so a thread that Shutdown() detached while it was inside a callback can return from it and exit, and a
+    // handler an external io_context runs (or destroys) after the Scheduler is gone finds the node pool alive.
+    // - handler_memory_, node_pool_: See the Scheduler members of the same names, which refer to these (handler_memory_ only
+    //                    on the Scheduler's own io_service).
+    // - in_handlers_:    Threads running a handler of the Scheduler, but not inside a user callback (see GuardedHandler).
+    // - in_callbacks_:   Threads inside a user callback (see CallbackScope).
+    // - abandoned_:      Set by Shutdown() once it is done waiting: handlers return at once, and a thread that returns from
+    //                    a callback unwinds its handler.
+    // - live_threads_:   Service threads that have not exited (guarded by mutex_; thread_exited_ is notified on exit).
+    // - callback_error_policy_, callback_error_handler_: Copies of the SchedulerOptions (see RunCallback()).
+    // - callback_errors_: Callback invocations that threw.
+    // - event_sink_:      See SchedulerOptions::event_sink (never null).
+    // - timer_store_, timer_store_handler_: The persistent timer store and TimerStoreOptions::handler (null and empty
+    //                     without a store). Shared with the callbacks of persistent timers (see FirePersistent()).
+    struct Runtime final
+    {
+        HandlerMemoryPool handler_memory_{};
+        FixedBlockPool node_pool_{ sizeof(TimerNode), 1024 };
+        CallbackErrorPolicy callback_error_policy_{ CallbackErrorPolicy::Log };
+        CallbackErrorHandler callback_error_handler_{};
+        std::atomic<uint64_t> callback_errors_{ 0 };
+        std::shared_ptr<SchedulerEventSink> event_sink_{};
+        std::unique_ptr<TimerStore> timer_store_{};
+        PersistentTimerHandler timer_store_handler_{};
+        std::atomic<int64_t> in_handlers_{ 0 };
+        std::atomic<int64_t> in_callbacks_{ 0 };
+        std::atomic<bool> abandoned_{ false };
+        std::mutex mutex_{};
+        std::condition_variable thread_exited_{};
+        std::size_t live_threads_{ 0 };
+    };
+
+    // ShutDownError: Thrown by Submit() once the Scheduler is shut down (reported as SchedulerEventKind::Rejected).
+    struct ShutDownError : std::logic_error
+    {
+        ShutDownError() : std::logic_error("the scheduler is shut down")
+        {
+        }
+    };
+
+    // AbandonedThread: Thrown on a thread that Shutdown() abandoned, as soon as its callback returns; caught by GuardedHandler.
+    struct AbandonedThread
+    {
+    };
+
+    // CallbackScope: Marks the calling thread as inside a user callback, instead of running Scheduler code, for the lifetime
+    // of the scope.
+    // - Shutdown() waits for the threads running Scheduler code, which finish quickly, but not for those inside a callback
+    //   (see RunCallback()).
+    // - All accesses are sequentially consistent: either Shutdown() sees a thread leave its callback and waits for it, or
+    //   the thread sees abandoned_ and unwinds. A thread is counted in in_callbacks_ before it leaves in_handlers_, so
+    //   Shutdown() never misses it.
+    class CallbackScope final
+    {
+    public:
+
+        explicit CallbackScope(Runtime& runtime) : runtime_(runtime)
+        {
+            runtime_.in_callbacks_.fetch_add(1);
+            runtime_.in_handlers_.fetch_sub(1);
+            if (runtime_.abandoned_.load()) {
+                runtime_.in_handlers_.fetch_add(1);
+                runtime_.in_callbacks_.fetch_sub(1);
+                throw AbandonedThread{};
+            }
+        }
+
+        CallbackScope(const CallbackScope&) = delete;
+        CallbackScope& operator=(const CallbackScope&) = delete;
+
+        ~CallbackScope()
+        {
+            runtime_.in_handlers_.fetch_add(1);
+            runtime_.in_callbacks_.fetch_sub(1);
+        }
+
+    private:
+
+        Runtime& runtime_;
+    };
+
+    // HandlerScope: Counts the calling thread in in_handlers_ for the lifetime of the scope (see GuardedHandler).
+    class HandlerScope final
+    {
+    public:
+
+        explicit HandlerScope(Runtime& runtime) : runtime_(runtime)
+        {
+            runtime_.in_handlers_.fetch_add(1);
+        }
+
+        HandlerScope(const HandlerScope&) = delete;
+        HandlerScope& operator=(const HandlerScope&) = delete;
+
+        ~HandlerScope()
+        {
+            runtime_.in_handlers_.fetch_sub(1);
+        }
+
+    private:
+
+        Runtime& runtime_;
+    };
+
+    // GuardedHandler<Handler>: Wraps every handler the Scheduler hands to Asio (see Pooled()).
+    // - Shares ownership of the Runtime, so its node pool outlives the handler (which may refer to a node) even on an
+    //   external io_context that runs or destroys it after the Scheduler is gone.
+    // - Counts the calling thread in Runtime::in_handlers_ while it runs, and does nothing once Shutdown() is done with the
+    //   Scheduler (which may have been destroyed meanwhile). An AbandonedThread thrown by RunCallback() ends here.
+    template <typename Handler>
+    class GuardedHandler final
+    {
+    public:
+
+        GuardedHandler(std::shared_ptr<Runtime> runtime, Handler handler) : runtime_(std::move(runtime)), handler_(std::move(handler))
+        {
+        }
+
+        template <typename... Args>
+        void operator()(Args&&... args)
+        {
+            HandlerScope scope(*runtime_);
+            if (runtime_->abandoned_.load()) {
+                return;
+            }
+
+            try {
+                handler_(std::forward<Args>(args)...);
+            } catch (const AbandonedThread&) {
+                // Shutdown() gave up on this thread while it ran a callback (expected; not an error).
+            }
+        }
+
+    private:
+
+        std::shared_ptr<Runtime> runtime_;
+        Handler handler_;
+    };
+
+    // NodeDeleter / NodePtr: Owning pointer to a pooled TimerNode (used while a node is in flight to engine_strand_).
+    struct NodeDeleter
+    {
+        Scheduler* scheduler_{ nullptr };
+
+        void operator()(TimerNode* node) const noexcept { scheduler_->DestroyNode(node); }
+    };
+
+    using NodePtr = std::unique_ptr<TimerNode, NodeDeleter>;
+
+    // NodeChain: An owning, singly-linked chain of nodes in flight to engine_strand_ (a ScheduleTimers batch).
+    // - Linked through TimingWheelHook::next_, so building a batch allocates nothing beyond the nodes.
+    // - Nodes still in the chain when it is destroyed are returned to the pool.
+    class NodeChain final
+    {
+    public:
+
+        explicit NodeChain(Scheduler* scheduler) noexcept : scheduler_(scheduler)
+        {
+        }
+
+        // Adopts a chain released by another NodeChain (see Release()).
+        NodeChain(Scheduler* scheduler, TimerNode* head) noexcept : scheduler_(scheduler), head_(head), tail_(head)
+        {
+            while (tail_ != nullptr && tail_->next_ != nullptr) {
+                tail_ = static_cast<TimerNode*>(tail_->next_);
+            }
+        }
+
+        NodeChain(NodeChain&& other) noexcept :
+            scheduler_(other.scheduler_), head_(std::exchange(other.head_, nullptr)), tail_(std::exchange(other.tail_, nullptr))
+        {
+        }
+
+        NodeChain(const NodeChain&) = delete;
+        NodeChain& operator=(const NodeChain&) = delete;
+        NodeChain& operator=(NodeChain&&) = delete;
+
+        ~NodeChain()
+        {
+            while (NodePtr node = PopFront()) {
+            }
+        }
+
+        void PushBack(NodePtr node) noexcept
+        {
+            TimerNode* raw = node.release();
+            raw->next_ = nullptr;
+            if (tail_ != nullptr) {
+                tail_->next_ = raw;
+            } else {
+                head_ = raw;
+            }
+            tail_ = raw;
+        }
+
+        TimerNode* Head() const noexcept { return head_; }
+
+        // Release(): Gives up ownership of the nodes (after Head() has been handed over).
+        void Release() noexcept
+        {
+            head_ = tail_ = nullptr;
+        }
+
+        NodePtr PopFront() noexcept
+        {
+            TimerNode* raw = head_;
+            if (raw != nullptr) {
+                head_ = static_cast<TimerNode*>(raw->next_);
+                tail_ = head_ != nullptr ? tail_ : nullptr;
+                raw->next_ = nullptr;
+            }
+            return NodePtr(raw, NodeDeleter{ scheduler_ });
+        }
+
+        // SortByDeadline(): Stable merge sort of the chain by deadline_ (O(n log n), no allocation).
+        void SortByDeadline() noexcept
+        {
+            head_ = MergeSort(head_);
+            for (tail_ = head_; tail_ != nullptr && tail_->next_ != nullptr; tail_ = static_cast<TimerNode*>(tail_->next_)) {
+            }
+        }
+
+    private:
+
+        static TimerNode* MergeSort(TimerNode* head) noexcept
+        {
+            if (head == nullptr || head->next_ == nullptr) {
+                return head;
+            }
+
+            // Split in the middle (slow/fast pointers):
+            TimerNode* slow = head;
+            for (TimerNode* fast = static_cast<TimerNode*>(head->next_); fast != nullptr && fast->next_ != nullptr;
+                fast = static_cast<TimerNode*>(fast->next_->next_)) {
+                slow = static_cast<TimerNode*>(slow->next_);
+            }
+            TimerNode* second = static_cast<TimerNode*>(slow->next_);
+            slow->next_ = nullptr;
+
+            TimerNode* left = MergeSort(head);
+            TimerNode* right = MergeSort(second);
+
+            TimingWheelHook merged{};
+            TimingWheelHook* tail = &merged;
+            while (left != nullptr && right != nullptr) {
+                TimerNode*& next = right->deadline_ < left->deadline_ ? right : left;
+                tail->next_ = next;
+                tail = next;
+                next = static_cast<TimerNode*>(next->next_);
+            }
+            tail->next_ = left != nullptr ? left : right;
+            return static_cast<TimerNode*>(merged.next_);
+        }
+
+        Scheduler* scheduler_;
+        TimerNode* head_{ nullptr };
+        TimerNode* tail_{ nullptr };
+    };
+
+    // Submission: A call of the public API on its way to engine_strand_ through submissions_.
+    // - kind_:     What to apply.
+    // - timer_id_: The timer (Cancel, Reschedule).
+    // - deadline_: The new deadline (Schedule, Reschedule).
+    // - node_:     Schedule, Upsert: the new node; ScheduleBatch: the head of a NodeChain. Owned by the submission until applied.
+    struct Submission
+    {
+        enum class Kind : uint8_t
+        {
+            Schedule,
+            ScheduleBatch,
+            Cancel,
+            Reschedule,
+            Upsert
+        };
+
+        Kind kind_{ Kind::Schedule };
+        uint64_t timer_id_{ 0 };
+        std::chrono::steady_clock::time_point deadline_{};
+        TimerNode* node_{ nullptr };
+    };
+
+    // ScheduleTimerImpl<OneShot>(timer_id, deadline, period, catch_up, affinity_key, callback, callback_args...)
+    //
+    // Common implementation of the ScheduleTimer and SchedulePeriodic overloads (`period` is zero for one-shot timers).
+    // Creates a timer node holding the bound callback and queues its insertion to engine_strand_, which owns the timer index
+    // and the selected engine, and handles potential errors during setup.
+    template <bool OneShot, typename Callback, typename... Args>
+    void ScheduleTimerImpl(const uint64_t timer_id, const TimerDeadline& deadline, const std::chrono::nanoseconds period,
+        const CatchUpPolicy catch_up, const uint64_t affinity_key, Callback&& callback, Args&&... callback_args)
+    {
+        try {
+            NodePtr node = MakeTimerNode<OneShot>(timer_id, period, catch_up, affinity_key, std::forward<Callback>(callback), std::forward<Args>(callback_args)...);
+            node->slack_ = deadline.Slack();
+            node->spin_ = deadline.Spin();
+
+            // Once queued, the submission owns the node until it is indexed (or discarded by the destructor):
+            Submit({ Submission::Kind::Schedule, timer_id, deadline.Resolve(), node.get() });
+            node.release();
+        } catch (const std::exception& e) {
+            Report(SchedulerEventKind::ScheduleFailed, timer_id, e);
+        }
+    }
+
+    // ScheduleKeyedImpl(mode, timer_id, deadline, interval, affinity_key, callback, callback_args...)
+    //
+    // Common implementation of the Debounce and Throttle overloads: creates a one-shot node holding the bound callback and
+    // queues it to engine_strand_ as an Upsert, which merges it into a pending node of the same mode (see Upsert()).
+    // - `interval`: Throttle only (see TimerNode::interval_).
+    template <typename Callback, typename... Args>
+    void ScheduleKeyedImpl(const TimerMode mode, const uint64_t timer_id, const std::chrono::steady_clock::time_point deadline,
+        const std::chrono::nanoseconds interval, const uint64_t affinity_key, Callback&& callback, Args&&... callback_args)
+    {
+        try {
+            NodePtr node = MakeTimerNode<true>(timer_id, {}, {}, affinity_key, std::forward<Callback>(callback), std::forward<Args>(callback_args)...);
+            node->mode_ = mode;
+            node->interval_ = interval;
+
+            Submit({ Submission::Kind::Upsert, timer_id, deadline, node.get() });
+            node.release();
+        } catch (const std::exception& e) {
+            Report(SchedulerEventKind::ScheduleFailed, timer_id, e);
+        }
+    }
+
+    // PersistentCallback(timer_id, sequence): The callback of a persistent timer (see FirePersistent()).
+    TimerCallback PersistentCallback(const uint64_t timer_id, const uint64_t sequence) const
+    {
+        return [runtime = runtime_, timer_id, sequence]() { FirePersistent(*runtime, timer_id, sequence); };
+    }
+
+    // FirePersistent(runtime, timer_id, sequence)
+    //
+    // Runs a persistent timer: reads its payload from the store, passes it to the handler and, once the handler has returned,
+    // erases the timer from the store. A handler that throws leaves the timer in the store (to fire after a restart), and
+    // its exception to the callback error policy.
+    // - Static: holds the Runtime, which owns the store, like the service threads (see Runtime).
+    static void FirePersistent(Runtime& runtime, const uint64_t timer_id, const uint64_t sequence)
+    {
+        thread_local std::vector<std::byte> payload{};
+        if (!runtime.timer_store_->Read(timer_id, sequence, payload)) {
+            return;
+        }
+
+        runtime.timer_store_handler_(timer_id, payload);
+        EraseStored(runtime, timer_id, sequence);
+    }
+
+    // ForgetStored(node)
+    //
+    // Erases a cancelled or replaced persistent timer from the store (engine_strand_ only; no effect on other timers).
+    void ForgetStored(const TimerNode* node) noexcept
+    {
+        if (node->store_sequence_ != 0) {
+            EraseStored(*runtime_, node->timer_id_, node->store_sequence_);
+        }
+    }
+
+    // EraseStored(runtime, timer_id, sequence): Erases a timer from the store, reporting a failure (the timer then fires
+    // again after a restart).
+    static void EraseStored(Runtime& runtime, const uint64_t timer_id, const uint64_t sequence) noexcept
+    {
+        try {
+            runtime.timer_store_->Erase(timer_id, sequence);
+        } catch (const std::exception& e) {
+            Report(runtime, SchedulerEventKind::StoreFailed, timer_id, e.what());
+        }
+    }
+
+    // ReloadTimerStore()
+    //
+    // Schedules the timers pending in the store, as one batch (see ScheduleTimers()), when the Scheduler is constructed.
+    // - Deadlines are converted from system_clock to steady_clock time. Overdue timers keep their (past) deadlines, so they
+    //   fire right away, and the AsioTimer engine fires them in deadline order; with OverduePolicy::Drop, they are erased.
+    // - Failures are reported (SchedulerEventKind::StoreFailed), not thrown: the Scheduler is running by then.
+    void ReloadTimerStore() noexcept
+    {
+        TimerStore& store = *runtime_->timer_store_;
+        try {
+            const auto now = std::chrono::steady_clock::now();
+            const auto system_now = std::chrono::system_clock::now();
+            const bool drop_overdue = options_.timer_store.overdue == OverduePolicy::Drop;
+
+            NodeChain batch(this);
+            std::vector<std::pair<uint64_t, uint64_t>> overdue{};
+            store.ForEach([&](const TimerStore::Entry& entry) {
+                if (drop_overdue && entry.deadline <= system_now) {
+                    overdue.emplace_back(entry.timer_id, entry.sequence);
+                    return;
+                }
+
+                NodePtr node = MakeNode();
+                node->timer_id_ = entry.timer_id;
+                node->affinity_key_ = entry.timer_id;
+                node->store_sequence_ = entry.sequence;
+                node->callback_ = PersistentCallback(entry.timer_id, entry.sequence);
+                node->deadline_ = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(entry.deadline - system_now);
+                batch.PushBack(std::move(node));
+                });
+
+            for (const auto& [timer_id, sequence] : overdue) {
+                EraseStored(*runtime_, timer_id, sequence);
+            }
+
+            if (batch.Head() != nullptr) {
+                Submit({ Submission::Kind::ScheduleBatch, 0, {}, batch.Head() });
+                batch.Release();
+            }
+        } catch (const std::exception& e) {
+            Report(SchedulerEventKind::StoreFailed, std::nullopt, e); // (The timers not scheduled stay in the store)
+        }
+    }
+
+    // ToSystemTime(deadline): A steady_clock deadline as system_clock time (as of now), for the timer store.
+    static std::chrono::system_clock::time_point ToSystemTime(const std::chrono::steady_clock::time_point deadline) noexcept
+    {
+        return std::chrono::system_clock::now() +
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(deadline - std::chrono::steady_clock::now());
+    }
+
+    // ScheduleIdleImpl(timer_id, timeout, affinity_key, callback, callback_args...)
+    //
+    // Common implementation of the ScheduleIdleTimeout overloads: creates the IdleTimeoutState (its last activity is now),
+    // and a one-shot node sharing it, due `timeout` from now.
+    // - If the state cannot be allocated, the failure is reported like any other, and the returned handle is empty.
+    template <typename Callback, typename... Args>
+    IdleTimeout ScheduleIdleImpl(const uint64_t timer_id, const TimerDuration timeout, const uint64_t affinity_key, Callback&& callback, Args&&... callback_args)
+    {
+        IdleTimeout activity{};
+
+        try {
+            activity = IdleTimeout(new IdleTimeoutState());
+
+            NodePtr node = MakeTimerNode<true>(timer_id, {}, {}, affinity_key, std::forward<Callback>(callback), std::forward<Args>(callback_args)...);
+            node->mode_ = TimerMode::Idle;
+            node->interval_ = std::max(timeout.Get(), std::chrono::nanoseconds(1));
+            node->activity_ = activity;
+
+            Submit({ Submission::Kind::Schedule, timer_id, activity.LastActivity() + node->interval_, node.get() });
+            node.release();
+        } catch (const std::exception& e) {
+            Report(SchedulerEventKind::ScheduleFailed, timer_id, e);
+        }
+        return activity;
+    }
+
+    // ScheduleCompletionImpl(timer_id, deadline, affinity_key, callback, callback_args...)
+    //
+    // Common implementation of the ScheduleTimerCompletion overloads: binds the callback into a TimerCompletionCallback
+    // sharing a new TimerCompletionState with the returned handle, and schedules it as a one-shot timer.
+    // - If the state or the wrapper cannot be created, the failure is reported like any other, and the handle reports
+    //   TimerStatus::Cancelled (it is empty if the state could not be allocated).
+    template <typename Callback, typename... Args>
+    auto ScheduleCompletionImpl(const uint64_t timer_id, const TimerDeadline& deadline, const uint64_t affinity_key, Callback&& callback, Args&&... callback_args)
+    {
+        // (The one-shot node moves the arguments into the callback)
+        using Result = std::invoke_result_t<std::decay_t<Callback>&, uint64_t, std::decay_t<Args>&&...>;
+
+        TimerCompletion<Result> completion(nullptr);
+        TimerCompletionState<Result>* unclaimed = nullptr; // (The callback side's reference, until the wrapper holds it)
+        try {
+            unclaimed = new TimerCompletionState<Result>();
+            completion = TimerCompletion<Result>(unclaimed);
+            TimerCompletionCallback<Result, std::decay_t<Callback>> wrapper(unclaimed, std::forward<Callback>(callback));
+            unclaimed = nullptr;
+
+            // Should scheduling fail, the wrapper is destroyed unfired and the handle reports TimerStatus::Cancelled:
+            ScheduleTimerImpl<true>(timer_id, deadline, {}, {}, affinity_key, std::move(wrapper), std::forward<Args>(callback_args)...);
+        } catch (const std::exception& e) {
+            if (unclaimed != nullptr) {
+                unclaimed->Complete(TimerStatus::Cancelled);
+                unclaimed->Release();
+            }
+            Report(SchedulerEventKind::ScheduleFailed, timer_id, e);
+        }
+        return completion;
+    }
+
+    // ScheduleTimersImpl(specs, affinity_key, callback, callback_args...)
+    //
+    // Common implementation of the ScheduleTimers overloads. All the nodes are created on the calling thread and handed to
+    // engine_strand_ as a single submission; if any of them cannot be created, none of the timers is scheduled.
+    // - `affinity_key`: The strand affinity key for every timer of the batch, or std::nullopt to use each timer's id.
+    template <typename Callback, typename... Args>
+    void ScheduleTimersImpl(const std::span<const TimerSpec> specs, const std::optional<uint64_t> affinity_key, const Callback& callback, const Args&... callback_args)
+    {
+        if (specs.empty()) {
+            return;
+        }
+
+        try {
+            NodeChain batch(this);
+            for (const TimerSpec& spec : specs) {
+                NodePtr node = MakeTimerNode<true>(spec.timer_id, {}, {}, affinity_key.value_or(spec.timer_id), callback, callback_args...);
+                node->deadline_ = spec.duration.Resolve();
+                node->slack_ = spec.duration.Slack();
+                node->spin_ = spec.duration.Spin();
+                batch.PushBack(std::move(node));
+            }
+
+            Submit({ Submission::Kind::ScheduleBatch, 0, {}, batch.Head() });
+            batch.Release();
+        } catch (const std::exception& e) {
+            Report(SchedulerEventKind::ScheduleFailed, std::nullopt, e); // (A batch)
+        }
+    }
+
+    // MakeTimerNode<OneShot>(timer_id, period, catch_up, affinity_key, callback, callback_args...)
+    //
+    // Creates a pooled node holding the bound callback (everything but the deadline).
+    // - The callback and its arguments are forwarded into the bound callback: each is moved or copied exactly once.
+    // - OneShot: the bound callback runs once, so it moves the arguments into the call.
+    // - Periodic: the arguments are passed as lvalues on every tick, and the bound callback must be copyable (see Expire()).
+    template <bool OneShot, typename Callback, typename... Args>
+    NodePtr MakeTimerNode(const uint64_t timer_id, const std::chrono::nanoseconds period, const CatchUpPolicy catch_up,
+        const uint64_t affinity_key, Callback&& callback, Args&&... callback_args)
+    {
+        NodePtr node = MakeNode();
+        node->timer_id_ = timer_id;
+        node->affinity_key_ = affinity_key;
+        node->period_ = period;
+        node->catch_up_ = catch_up;
+
+        if constexpr (!OneShot) {
+            static_assert(std::is_copy_constructible_v<std::decay_t<Callback>> && (std::is_copy_constructible_v<std::decay_t<Args>> && ...),
+                "periodic timer callbacks and their arguments must be copyable");
+        }
+
+        // (Constructed in place: a lambda bound the same way would be moved again into callback_)
+        node->callback_.Emplace<BoundCallback<OneShot, std::decay_t<Callback>, std::decay_t<Args>...>>(timer_id,
+            std::forward<Callback>(callback), std::forward<Args>(callback_args)...);
+        return node;
+    }
+
+    // BoundCallback<OneShot, Callback, Args...>: A user callback bound to its timer id and arguments (see MakeTimerNode()).
+    template <bool OneShot, typename Callback, typename... Args>
+    struct BoundCallback
+    {
+        template <typename CallbackArg, typename... ArgArgs>
+        BoundCallback(const uint64_t timer_id, CallbackArg&& callback, ArgArgs&&... callback_args) :
+            timer_id_(timer_id),
+            callback_(std::forward<CallbackArg>(callback)),
+            callback_args_(std::forward<ArgArgs>(callback_args)...)
+        {
+        }
+
+        void operator()()
+        {
+            std::apply([this](Args&... callback_args) {
+                if constexpr (OneShot) {
+                    callback_(timer_id_, std::move(callback_args)...);
+                } else {
+                    callback_(timer_id_, callback_args...);
+                }
+                }, callback_args_);
+        }
+
+        uint64_t timer_id_;
+        Callback callback_;
+        std::tuple<Args...> callback_args_;
+    };
+
+    // MakeNode()
+    //
+    // Constructs a TimerNode in a block of node_pool_ (thread-safe; no heap allocation once the pool has grown).
+    NodePtr MakeNode()
+    {
+        void* memory = node_pool_.Allocate();
+        return NodePtr(::new (memory) TimerNode(), NodeDeleter{ this });
+    }
+
+    // DestroyNode(node)
+    //
+    // Destroys a TimerNode and returns its block to node_pool_.
+    void DestroyNode(TimerNode* node) noexcept
+    {
+        node->~TimerNode();
+        node_pool_.Deallocate(node);
+    }
+
+    // Submit(submission)
+    //
+    // Queues a submission for engine_strand_ (any thread). Lock-free on the fast path; the first submission into an idle queue
+    // also posts the drain (DrainSubmissions), so a burst of calls costs one post.
+    //
+    // Throws:
+    //   - ShutDownError (a std::logic_error) if the Scheduler is shutting down and the submission is not a cancellation (it is
+    //     not queued).
+    //   - std::bad_alloc if the ring is full and the overflow list cannot grow (the submission is not queued).
+    void Submit(const Submission& submission)
+    {
+        if (submission.kind_ != Submission::Kind::Cancel && shutting_down_.load(std::memory_order_relaxed)) {
+            throw ShutDownError{};
+        }
+
+        if (submissions_.Push(submission)) {
+            PostDrain();
+        }
+    }
+
+    // PostDrain()
+    //
+    // Posts DrainSubmissions() to engine_strand_. If that fails, the queued submissions wait for the next Submit() to post a
+    // drain (they are queued already, so the error is only logged).
+    void PostDrain() noexcept
+    {
+        try {
+            boost::asio::post(engine_strand_, Pooled([this] { DrainSubmissions(); }));
+        } catch (const std::exception& e) {
+            submissions_.AbortDrain();
+            Report(SchedulerEventKind::EngineFailed, std::nullopt, e);
+        }
+    }
+
+    // DrainSubmissions()
+    //
+    // Applies the queued submissions in order (engine_strand_ only). The wheel timer is re-armed once per drain.
+    // - After StopEngine(), only cancellations are applied; submissions that raced with Shutdown() are discarded.
+    void DrainSubmissions()
+    {
+        if (engine_stopped_) {
+            while (submissions_.Drain([this](const Submission& submission) {
+                if (submission.kind_ == Submission::Kind::Cancel) {
+                    ApplySubmission(submission);
+                } else {
+                    DiscardSubmission(submission);
+                }
+                })) {
+            }
+            active_timers_.store(index_.Size(), std::memory_order_relaxed);
+            return;
+        }
+
+        const bool more = submissions_.Drain([this](const Submission& submission) { ApplySubmission(submission); });
+        active_timers_.store(index_.Size(), std::memory_order_relaxed);
+
+        if (options_.engine == TimerEngine::TimingWheel) {
+            ArmWheelTimer();
+        }
+
+        if (more) {
+            PostDrain();
+        }
+    }
+
+    // ApplySubmission(submission)
+    //
+    // Applies one submission to the index and the engine (engine_strand_ only), taking ownership of its nodes.
+    void ApplySubmission(const Submission& submission) noexcept
+    {
+        try {
+            switch (submission.kind_) {
+            case Submission::Kind::Schedule:
+                InsertTimer(NodePtr(submission.node_, NodeDeleter{ this }), submission.deadline_, false);
+                break;
+
+            case Submission::Kind::ScheduleBatch: {
+                NodeChain batch(this, submission.node_);
+                InsertTimers(batch);
+                break;
+            }
+
+            case Submission::Kind::Cancel:
+                if (TimerNode* node = index_.Erase(submission.timer_id_)) {
+                    Disarm(node);
+                    ForgetStored(node);
+                    Release(node);
+                    cancelled_.fetch_add(1, std::memory_order_relaxed);
+                }
+                break;
+
+            case Submission::Kind::Reschedule:
+                if (TimerNode* node = index_.Find(submission.timer_id_)) {
+                    Disarm(node);
+                    Arm(node, submission.deadline_, false);
+                    if (node->store_sequence_ != 0) {
+                        runtime_->timer_store_->Update(node->timer_id_, node->store_sequence_, ToSystemTime(submission.deadline_));
+                    }
+                }
+                break;
+
+            case Submission::Kind::Upsert:
+                Upsert(NodePtr(submission.node_, NodeDeleter{ this }), submission.deadline_);
+                break;
+            }
+        } catch (const std::exception& e) {
+            Report(SchedulerEventKind::EngineFailed, submission.timer_id_, e);
+        }
+    }
+
+    // DiscardSubmission(submission)
+    //
+    // Frees the nodes of a submission that is not applied (the destructor, or a drain after StopEngine()).
+    void DiscardSubmission(const Submission& submission) noexcept
+    {
+        if (submission.kind_ == Submission::Kind::Schedule || submission.kind_ == Submission::Kind::Upsert) {
+            DestroyNode(submission.node_);
+        } else if (submission.kind_ == Submission::Kind::ScheduleBatch) {
+            NodeChain batch(this, submission.node_);
+        }
+    }
+
+    // RunDetached(task, promise)
+    //
+    // The root coroutine of Spawn(): awaits `task` and fulfils `promise` with its outcome.
+    template <typename T>
+    static DetachedTask RunDetached(Task<T> task, std::promise<T> promise)
+    {
+        try {
+            if constexpr (std::is_void_v<T>) {
+                co_await std::move(task);
+                promise.set_value();
+            } else {
+                promise.set_value(co_await std::move(task));
+            }
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+        }
+    }
+
+    // Pooled(handler)
+    //
+    // Binds `handler` to handler_memory_, so the operation Asio allocates for it comes from the pool, not the heap, and guards
+    // it against running after Shutdown() (see GuardedHandler).
+    // - On an external io_context, only with a pool the caller supplied (see Scheduler(io_context, handler_memory, options)):
+    //   the io_context may outlive runtime_'s, and Asio allocates some of its own operations (e.g., strand invokers) with a
+    //   handler's allocator, so without one these come from the heap.
+    template <typename Handler>
+    PooledHandler<GuardedHandler<Handler>> Pooled(Handler handler)
+    {
+        return PooledHandler<GuardedHandler<Handler>>(handler_memory_, GuardedHandler<Handler>(runtime_, std::move(handler)));
+    }
+
+    // InsertTimer(node, deadline, arm_wheel_timer)
+    //
+    // Indexes a new timer and arms it (engine_strand_ only). A pending timer with the same id is cancelled.
+    void InsertTimer(NodePtr node, const std::chrono::steady_clock::time_point deadline, const bool arm_wheel_timer = true)
+    {
+        if (TimerNode* replaced = index_.Insert(node->timer_id_, node.get())) {
+            Disarm(replaced);
+            ForgetStored(replaced);
+            Release(replaced);
+            cancelled_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        Arm(node.release(), deadline, arm_wheel_timer);
+    }
+
+    // Upsert(node, deadline)
+    //
+    // Applies a Debounce/Throttle call (engine_strand_ only).
+    // - A pending node with the same id and mode takes the new callback in place of its own (counted as suppressed if that
+    //   one had not run yet); the new node only carried the callback, and goes back to the pool.
+    //   - Debounce: the pending node is moved to the new deadline.
+    //   - Throttle: the pending node keeps its deadline, the end of the current window.
+    // - Otherwise, the node is inserted as a new timer (replacing a pending timer of another kind, like ScheduleTimer).
+    //   Throttle: the call is the leading edge, so its callback is dispatched right away, and the node is armed for the end
+    //   of the window with no callback (calls made before the callback runs already fall into the window).
+    void Upsert(NodePtr node, const std::chrono::steady_clock::time_point deadline)
+    {
+        TimerNode* pending = index_.Find(node->timer_id_);
+        if (pending == nullptr || pending->mode_ != node->mode_) {
+            if (node->mode_ != TimerMode::Throttle) {
+                InsertTimer(std::move(node), deadline, false);
+                return;
+            }
+
+            TimerCallback callback = std::move(node->callback_);
+            const uint64_t timer_id = node->timer_id_;
+            const auto spin = SpinMargin(node.get());
+            const Strand* strand = callback_strands_.empty() ? &engine_strand_ : &CallbackStrand(node.get());
+            const auto window_end = deadline + node->interval_;
+            InsertTimer(std::move(node), window_end, false);
+
+            // (Posted, as callbacks never run inside the drain of the submission queue)
+            pending_callbacks_.fetch_add(1, std::memory_order_relaxed);
+            boost::asio::post(*strand, Pooled([this, callback = std::move(callback), timer_id, deadline, spin]() mutable {
+                pending_callbacks_.fetch_sub(1, std::memory_order_relaxed);
+                InvokeCallback(callback, timer_id, deadline, spin);
+                }));
+            return;
+        }
+
+        if (pending->callback_) {
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+        }
+        pending->callback_ = std::move(node->callback_);
+        pending->affinity_key_ = node->affinity_key_;
+
+        if (pending->mode_ == TimerMode::Debounce) {
+            Disarm(pending);
+            Arm(pending, deadline, false);
+        }
+    }
+
+    // InsertTimers(batch)
+    //
+    // Inserts a ScheduleTimers batch (engine_strand_ only).
+    // - AsioTimer: the batch is sorted by deadline first, so each insertion into Asio's timer heap lands at the back
+    //   and does not sift.
+    // - TimingWheel: insertions are O(1) each; the driving timer is re-armed once per drain (DrainSubmissions).
+    void InsertTimers(NodeChain& batch)
+    {
+        if (options_.engine == TimerEngine::AsioTimer) {
+            batch.SortByDeadline();
+        }
+
+        while (NodePtr node = batch.PopFront()) {
+            const auto deadline = node->deadline_;
+            InsertTimer(std::move(node), deadline, false);
+        }
+    }
+
+    // Arm(node, deadline, arm_wheel_timer)
+    //
+    // Hands a node to the selected engine (engine_strand_ only). The engine owns the node from here on.
+    // - The engine expires the node at its coalesced expiry (see CoalescedExpiry()), less its precision spin margin (see
+    //   SpinMargin()); deadline_ keeps the exact deadline.
+    // - `arm_wheel_timer`: TimingWheel only; false when the caller re-arms the driving timer itself after a batch.
+    void Arm(TimerNode* node, const std::chrono::steady_clock::time_point deadline, const bool arm_wheel_timer = true)
+    {
+        node->deadline_ = deadline;
+        ++arms_since_;
+
+        const auto expiry = CoalescedExpiry(node) - SpinMargin(node);
+
+        if (options_.engine == TimerEngine::TimingWheel) {
+            wheel_->Insert(node, ToWheelTick(expiry, true));
+            if (arm_wheel_timer) {
+                ArmWheelTimer();
+            }
+            return;
+        }
+
+        if (!node->IsLinked()) {
+            asio_nodes_.PushBack(node);
+            node->asio_timer_.emplace(io_service_);
+        }
+
+        node->asio_timer_->expires_at(expiry);
+
+        ++node->pending_waits_;
+        node->asio_timer_->async_wait(boost::asio::bind_executor(engine_strand_, Pooled([this, node, generation = node->generation_](const boost::system::error_code& e) {
+            if (node->retired_ || generation != node->generation_) {
+                // Cancelled, or superseded by RescheduleTimer (expected; not an error).
+                --node->pending_waits_;
+                ReleaseAsioNode(node);
+            } else if (e) {
+                // Handle error
+                --node->pending_waits_;
+                Report(*runtime_, SchedulerEventKind::TimerWaitFailed, node->timer_id_, e.message(), e);
+                index_.Erase(node->timer_id_);
+                active_timers_.store(index_.Size(), std::memory_order_relaxed);
+                Release(node);
+            } else {
+                const auto expiry = node->asio_timer_->expiry();
+                if (expiry != last_asio_expiry_) {
+                    last_asio_expiry_ = expiry;
+                    wakeups_.fetch_add(1, std::memory_order_relaxed);
+                }
+                ExpireInBatch(node, generation); // (Keeps its pending wait until then)
+            }
+            })));
+    }
+
+    // ExpireInBatch(node, generation)
+    //
+    // Queues an AsioTimer node whose wait has completed, and expires the queued nodes together, in deadline order
+    // (engine_strand_ only). The timers of one coalescing cell (see CoalescedExpiry()) share one expiry, which Asio's timer
+    // queue completes in no particular order: the batch restores the order of their deadlines.
+    // - The batch is expired by a handler posted to io_service_ (not to the strand, which would run it right after this
+    //   one): it queues behind the other waits that the same wakeup completed, so they join the batch first.
+    // - A queued node keeps its pending wait (so it is not freed); one cancelled or rescheduled in the meantime is only
+    //   released then.
+    void ExpireInBatch(TimerNode* node, const uint32_t generation)
+    {
+        expiring_.push_back(ExpiringNode{ node, generation });
+        if (expiring_.size() > 1) {
+            return;
+        }
+
+        boost::asio::post(io_service_, boost::asio::bind_executor(engine_strand_, Pooled([this] {
+            std::stable_sort(expiring_.begin(), expiring_.end(), [](const ExpiringNode& a, const ExpiringNode& b) {
+                return a.node_->deadline_ < b.node_->deadline_;
+                });
+
+            for (const ExpiringNode& expiring : expiring_) {
+                TimerNode* node = expiring.node_;
+                --node->pending_waits_;
+                if (node->retired_ || expiring.generation_ != node->generation_) {
+                    ReleaseAsioNode(node);
+                } else {
+                    Expire(node);
+                }
+            }
+            expiring_.clear();
+            })));
+    }
+
+    // CoalescedExpiry(node)
+    //
+    // Returns when the engine should expire a node: its deadline_, rounded up to a grid of its coalescing window, so every
+    // timer due within the same cell of the grid expires at the same instant (one wakeup; the nodes are expired as a batch,
+    // in deadline order: see ExpireInBatch()). Cells are aligned to wheel_epoch_, not to the deadlines: timers less than a
+    // window apart can still straddle a boundary.
+    // - The window is the node's slack, shrunk under low load (SchedulerOptions::adaptive_slack), then rounded down to a
+    //   power of two nanoseconds. Power-of-two grids nest, so timers with different windows still share wakeups, and the
+    //   expiry is never more than the slack past the deadline.
+    std::chrono::steady_clock::time_point CoalescedExpiry(const TimerNode* node)
+    {
+        const auto slack = node->slack_.value_or(options_.timer_slack);
+        if (slack.count() <= 0 || node->deadline_ <= wheel_epoch_) {
+            return node->deadline_;
+        }
+
+        double window = static_cast<double>(slack.count());
+        if (options_.adaptive_slack) {
+            // Timers expected to be armed within one window at the current rate; below kCoalesceTarget, the window shrinks
+            // in proportion (at one or two timers per window, merging wakeups saves next to nothing):
+            const double per_window = ArmRate() * window / 1e9;
+            if (per_window < kCoalesceTarget) {
+                window *= per_window / kCoalesceTarget;
+            }
+        }
+
+        const uint64_t grid = std::bit_floor(static_cast<uint64_t>(window));
+        if (grid <= 1) {
+            return node->deadline_;
+        }
+
+        const auto offset = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(node->deadline_ - wheel_epoch_).count());
+        const uint64_t aligned = (offset + grid - 1) / grid * grid;
+        return wheel_epoch_ + std::chrono::nanoseconds(aligned);
+    }
+
+    // SpinMargin(node): How early the engine wakes up for a node in precision mode (zero: not in precision mode).
+    std::chrono::nanoseconds SpinMargin(const TimerNode* node) const noexcept
+    {
+        const auto margin = node->spin_.value_or(options_.precision_spin);
+        return margin.count() > 0 ? margin : std::chrono::nanoseconds(0);
+    }
+
+    // ArmRate()
+    //
+    // Timers armed per second (engine_strand_ only): a moving average over kArmRateInterval periods, or the rate of the
+    // current period if that is higher (so a burst widens the window right away).
+    double ArmRate()
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const auto elapsed = now - arm_rate_since_;
+        const double current = static_cast<double>(arms_since_) / std::chrono::duration<double>(std::max<std::chrono::steady_clock::duration>(elapsed, std::chrono::milliseconds(1))).count();
+
+        if (elapsed >= kArmRateInterval) {
+            // After an idle gap of several periods the old average no longer says anything:
+            arm_rate_ = elapsed >= kArmRateInterval * 4 ? current : (arm_rate_ + current) / 2;
+            arm_rate_since_ = now;
+            arms_since_ = 0;
+            return arm_rate_;
+        }
+
+        return std::max(arm_rate_, current);
+    }
+
+    // Disarm(node)
+    //
+    // Takes a node out of its engine without invoking it (engine_strand_ only).
+    // - TimingWheel: unlinks the node from its slot (O(1)).
+    // - AsioTimer: cancels the node's wait; the aborted handler only drops its reference to the node.
+    void Disarm(TimerNode* node)
+    {
+        if (options_.engine == TimerEngine::TimingWheel) {
+            wheel_->Remove(node);
+            return;
+        }
+
+        ++node->generation_;
+        node->asio_timer_->cancel();
+    }
+
+    // Release(node)
+    //
+    // Frees a disarmed node that is no longer indexed (engine_strand_ only).
+    void Release(TimerNode* node)
+    {
+        if (options_.engine == TimerEngine::TimingWheel) {
+            DestroyNode(node);
+            return;
+        }
+
+        node->retired_ = true;
+        ReleaseAsioNode(node);
+    }
+
+    // ReleaseAsioNode(node)
+    //
+    // Deletes a retired AsioTimer node once no async_wait handler refers to it any more.
+    void ReleaseAsioNode(TimerNode* node)
+    {
+        if (node->retired_ && node->pending_waits_ == 0) {
+            node->Unlink();
+            DestroyNode(node);
+        }
+    }
+
+    // Expire(node)
+    //
+    // Handles a node its engine has just expired and let go of (engine_strand_ only).
+    // - One-shot: un-indexes and releases the node, and runs its callback.
+    // - Periodic: re-arms the node for its next deadline on the original grid (see CatchUpPolicy), then runs its callback.
+    // - Throttle: while calls keep coming, runs the latest one and re-arms the node for the end of a new window; a window
+    //   that ends with no call releases the node, like a one-shot timer (with no callback to run).
+    // - Idle: if there was activity since the node was armed, re-arms it for the idle timeout from the last activity, and
+    //   does not run the callback; otherwise, expires like a one-shot timer.
+    void Expire(TimerNode* node)
+    {
+        const auto deadline = node->deadline_;
+        const auto spin = SpinMargin(node);
+
+        if (node->mode_ == TimerMode::Idle && !engine_stopped_) {
+            const auto idle_until = node->activity_.LastActivity() + node->interval_;
+            if (idle_until > deadline) {
+                Arm(node, idle_until);
+                return;
+            }
+        }
+
+        if (node->mode_ == TimerMode::Throttle && node->callback_ && !engine_stopped_) {
+            TimerCallback callback = std::move(node->callback_);
+            const uint64_t timer_id = node->timer_id_;
+            Arm(node, std::chrono::steady_clock::now() + node->interval_);
+
+            if (callback_strands_.empty()) {
+                InvokeCallback(callback, timer_id, deadline, spin);
+            } else {
+                pending_callbacks_.fetch_add(1, std::memory_order_relaxed);
+                boost::asio::post(CallbackStrand(node), Pooled([this, callback = std::move(callback), timer_id, deadline, spin]() mutable {
+                    pending_callbacks_.fetch_sub(1, std::memory_order_relaxed);
+                    InvokeCallback(callback, timer_id, deadline, spin);
+                    }));
+            }
+            return;
+        }
+
+        if (node->period_.count() == 0) {
+            index_.Erase(node->timer_id_);
+            active_timers_.store(index_.Size(), std::memory_order_relaxed);
+            node->retired_ = true;
+
+            if (!node->callback_) {
+                Release(node);
+                return;
+            }
+
+            if (callback_strands_.empty()) {
+                InvokeCallback(node->callback_, node->timer_id_, deadline, spin);
+            } else {
+                pending_callbacks_.fetch_add(1, std::memory_order_relaxed);
+                boost::asio::post(CallbackStrand(node), Pooled([this, callback = std::move(node->callback_), timer_id = node->timer_id_, deadline, spin]() mutable {
+                    pending_callbacks_.fetch_sub(1, std::memory_order_relaxed);
+                    InvokeCallback(callback, timer_id, deadline, spin);
+                    }));
+            }
+
+            Release(node);
+            return;
+        }
+
+        // Ticks on the grid (deadline_ + n * period_) that have also passed already:
+        const auto now = std::chrono::steady_clock::now();
+        const auto missed = now > node->deadline_ ? (now - node->deadline_) / node->period_ : 0;
+
+        auto next = node->deadline_ + node->period_;
+        bool invoke = true;
+        if (missed > 0 && node->catch_up_ != CatchUpPolicy::Burst) {
+            next += node->period_ * missed;
+            invoke = node->catch_up_ == CatchUpPolicy::Coalesce;
+        }
+
+        Arm(node, next);
+
+        if (invoke) {
+            if (callback_strands_.empty()) {
+                InvokeCallback(node->callback_, node->timer_id_, deadline, spin);
+            } else {
+                pending_callbacks_.fetch_add(1, std::memory_order_relaxed);
+                boost::asio::post(CallbackStrand(node), Pooled([this, callback = node->callback_, timer_id = node->timer_id_, deadline, spin]() mutable {
+                    pending_callbacks_.fetch_sub(1, std::memory_order_relaxed);
+                    InvokeCallback(callback, timer_id, deadline, spin);
+                    }));
+            }
+        }
+    }
+
+    // InvokeCallback(callback, timer_id, deadline, spin)
+    //
+    // Runs an expired timer's callback (on whichever thread runs callbacks), counting it and, with
+    // SchedulerOptions::latency_histograms, recording its lateness against `deadline` and its run time.
+    // - `spin`: The timer's precision spin margin, if in precision mode. The engine woke up early for it, so the callback waits
+    //   for `deadline` in SpinUntil() first.
+    // - Throws AbandonedThread if Shutdown() gave up on this thread (see RunCallback()).
+    void InvokeCallback(TimerCallback& callback, const uint64_t timer_id, const std::chrono::steady_clock::time_point deadline,
+        const std::chrono::nanoseconds spin)
+    {
+        fired_.fetch_add(1, std::memory_order_relaxed);
+
+        if (spin.count() > 0) {
+            const auto spin_start = std::chrono::steady_clock::now();
+            const auto start = SpinUntil(deadline, spin_start, spin);
+            if (options_.latency_histograms) {
+                spin_time_.Record(start - spin_start);
+                precision_lateness_.Record(start - deadline);
+            }
+        }
+
+        if (!options_.latency_histograms) {
+            RunCallback(*runtime_, callback, timer_id);
+            return;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        lateness_.Record(start - deadline);
+        RunCallback(*runtime_, callback, timer_id);
+        callback_runtime_.Record(std::chrono::steady_clock::now() - start);
+    }
+
+    // SpinUntil(deadline, now, margin)
+    //
+    // Busy-waits until `deadline` (precision mode) and returns the time it stopped at. steady_clock::now() is a vDSO read of
+    // the TSC on Linux (tens of nanoseconds), so the loop sees the deadline within about that much.
+    // - Does not wait when the deadline is more than `margin` away: the timer was fired early on purpose (e.g.,
+    //   ShutdownPolicy::FireDueNow), not woken up early for precision.
+    static std::chrono::steady_clock::time_point SpinUntil(const std::chrono::steady_clock::time_point deadline,
+        std::chrono::steady_clock::time_point now, const std::chrono::nanoseconds margin) noexcept
+    {
+        if (deadline - now > margin) {
+            return now;
+        }
+
+        while (now < deadline) {
+            CpuRelax();
+            now = std::chrono::steady_clock::now();
+        }
+        return now;
+    }
+
+    // CpuRelax(): Tells the CPU that the thread is spinning (frees pipeline resources for a sibling hyper-thread).
+    static void CpuRelax() noexcept
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    // RunCallback(runtime, callback, timer_id)
+    //
+    // Invokes a user callback inside a CallbackScope. Static, and handed `runtime` (which the calling handler shares ownership
+    // of), so nothing here touches a Scheduler that Shutdown() gave up waiting for and that was destroyed meanwhile.
+    // - An exception thrown by the callback stops here (see OnCallbackError()). The try block costs nothing until one is
+    //   thrown (table-based unwinding).
+    //
+    // Throws:
+    //   - AbandonedThread if Shutdown() gave up on this thread before or while the callback ran; it unwinds to the
+    //     GuardedHandler without touching the Scheduler.
+    static void RunCallback(Runtime& runtime, TimerCallback& callback, const uint64_t timer_id)
+    {
+        {
+            CallbackScope scope(runtime);
+            try {
+                callback();
+            } catch (...) {
+                OnCallbackError(runtime, timer_id, std::current_exception());
+            }
+        }
+
+        if (runtime.abandoned_.load()) {
+            throw AbandonedThread{};
+        }
+    }
+
+    // OnCallbackError(runtime, timer_id, error)
+    //
+    // Counts a throwing callback and applies the CallbackErrorPolicy (still inside the callback's CallbackScope, so a slow or
+    // blocking error handler is treated as part of the callback by Shutdown()).
+    static void OnCallbackError(Runtime& runtime, const uint64_t timer_id, const std::exception_ptr& error) noexcept
+    {
+        runtime.callback_errors_.fetch_add(1, std::memory_order_relaxed);
+
+        if (runtime.callback_error_policy_ == CallbackErrorPolicy::Handler && runtime.callback_error_handler_) {
+            try {
+                runtime.callback_error_handler_(timer_id, error);
+            } catch (const std::exception& e) {
+                Report(runtime, SchedulerEventKind::ErrorHandlerThrew, timer_id, e.what());
+            } catch (...) {
+                Report(runtime, SchedulerEventKind::ErrorHandlerThrew, timer_id, {});
+            }
+            return;
+        }
+
+        try {
+            std::rethrow_exception(error);
+        } catch (const std::exception& e) {
+            Report(runtime, SchedulerEventKind::CallbackThrew, timer_id, e.what());
+        } catch (...) {
+            Report(runtime, SchedulerEventKind::CallbackThrew, timer_id, {});
+        }
+
+        if (runtime.callback_error_policy_ == CallbackErrorPolicy::Terminate) {
+            runtime.event_sink_->Flush();
+            std::terminate();
+        }
+    }
+
+    // Report(runtime, kind, timer, message, error)
+    //
+    // Publishes an error to the event sink. Static, for the users of the Runtime that may outlive the Scheduler.
+    static void Report(Runtime& runtime, const SchedulerEventKind kind, const std::optional<uint64_t> timer, const std::string_view message,
+        const std::error_code error = {}) noexcept
+    {
+        runtime.event_sink_->Publish(MakeSchedulerEvent(kind, timer, message, error));
+    }
+
+    // Report(kind, timer, e)
+    //
+    // Publishes a caught exception to the event sink; a ShutDownError is reported as SchedulerEventKind::Rejected.
+    void Report(const SchedulerEventKind kind, const std::optional<uint64_t> timer, const std::exception& e) const noexcept
+    {
+        Report(*runtime_, dynamic_cast<const ShutDownError*>(&e) != nullptr ? SchedulerEventKind::Rejected : kind, timer, e.what());
+    }
+
+    // CallbackStrand(node): The strand of the pool that the node's affinity key hashes to (worker pool only).
+    const Strand& CallbackStrand(const TimerNode* node) const
+    {
+        return callback_strands_[MixTimerKey(node->affinity_key_) % callback_strands_.size()];
+    }
+
+    // SubmissionRingSlots(options, own_threads): The ring size of submissions_ (see SchedulerOptions::submission_queue_capacity).
+    static std::size_t SubmissionRingSlots(const SchedulerOptions& options, const bool own_threads) noexcept
+    {
+        if (options.submission_queue_capacity != 0) {
+            return options.submission_queue_capacity;
+        }
+        return own_threads ? 1024 : 64;
+    }
+
+    // MakeRuntime(options): Creates the Runtime, with the options that its static users need (see RunCallback()).
+    static std::shared_ptr<Runtime> MakeRuntime(const SchedulerOptions& options)
+    {
+        auto runtime = std::make_shared<Runtime>();
+        runtime->callback_error_policy_ = options.callback_error_policy;
+        runtime->callback_error_handler_ = options.callback_error_handler;
+        runtime->event_sink_ = options.event_sink ? options.event_sink : DefaultEventSink();
+        if (!options.timer_store.path.empty()) {
+            if (!options.timer_store.handler) {
+                throw std::invalid_argument("the timer store has no handler");
+            }
+            runtime->timer_store_ = std::make_unique<TimerStore>(options.timer_store);
+            runtime->timer_store_handler_ = options.timer_store.handler;
+        }
+        return runtime;
+    }
+
+    // MakeCallbackStrands(options)
+    //
+    // Creates the callback strand pool, or none when the Scheduler runs on a single thread.
+    std::vector<Strand> MakeCallbackStrands(const SchedulerOptions& options)
+    {
+        std::vector<Strand> strands{};
+        if (options.worker_threads > 1) {
+            strands.reserve(std::max<std::size_t>(options.callback_strands, 1));
+            for (std::size_t i = 0; i < strands.capacity(); ++i) {
+                strands.push_back(boost::asio::make_strand(io_service_));
+            }
+        }
+        return strands;
+    }
+
+    // ToWheelTick(time_point, round_up)
+    //
+    // Converts a time point to a wheel tick. Deadlines round up, so a timer never fires before its deadline;
+    // the current time rounds down, so the wheel never runs ahead of the clock.
+    uint64_t ToWheelTick(const std::chrono::steady_clock::time_point time_point, const bool round_up) const
+    {
+        if (time_point <= wheel_epoch_) {
+            return 0;
+        }
+
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(time_point - wheel_epoch_).count();
+        const auto tick = wheel_tick_.count();
+        return static_cast<uint64_t>(round_up ? (elapsed + tick - 1) / tick : elapsed / tick);
+    }
+
+    // Inverse of ToWheelTick().
+    std::chrono::steady_clock::time_point FromWheelTick(const uint64_t tick) const
+    {
+        return wheel_epoch_ + wheel_tick_ * tick;
+    }
+
+    // ArmWheelTimer()
+    //
+    // (Re)arms the single timer that drives the wheel for the next tick that can produce work.
+    // - Only re-arms when that tick is earlier than the one already armed, so a burst of inserts costs one async_wait.
+    void ArmWheelTimer()
+    {
+        const auto next_tick = wheel_->NextExpiryTick();
+        if (!next_tick || (wheel_armed_tick_ && *wheel_armed_tick_ <= *next_tick)) {
+            return;
+        }
+
+        wheel_armed_tick_ = *next_tick;
+        wheel_timer_.expires_at(FromWheelTick(*next_tick));
+        wheel_timer_.async_wait(boost::asio::bind_executor(engine_strand_, Pooled([this](const boost::system::error_code& e) {
+            if (e != boost::asio::error::operation_aborted) {
+                OnWheelTimer();
+            }
+            })));
+    }
+
+    // OnWheelTimer()
+    //
+    // Advances the wheel to the current time and expires the timers that are due, in deadline order.
+    void OnWheelTimer()
+    {
+        wheel_armed_tick_.reset();
+        wakeups_.fetch_add(1, std::memory_order_relaxed);
+
+        TimingWheelList expired{};
+        wheel_->Advance(ToWheelTick(std::chrono::steady_clock::now(), false), expired);
+
+        // In deadline order: the nodes of one tick (or one coalescing cell) are linked in the order they were armed.
+        while (TimingWheelHook* hook = expired.Front()) {
+            hook->Unlink();
+            expiring_.push_back(ExpiringNode{ static_cast<TimerNode*>(hook), 0 });
+        }
+        std::stable_sort(expiring_.begin(), expiring_.end(), [](const ExpiringNode& a, const ExpiringNode& b) {
+            return a.node_->deadline_ < b.node_->deadline_;
+            });
+        for (const ExpiringNode& expiring : expiring_) {
+            Expire(expiring.node_);
+        }
+        expiring_.clear();
+
+        ArmWheelTimer();
+    }
+
+    // StopEngine(policy, deadline)
+    //
+    // The engine side of Shutdown() (engine_strand_ only).
+    // - Applies the submissions made before the shutdown, then settles every pending timer according to `policy`
+    //   (FireDueNow fires them in deadline order).
+    // - Releases io_service_work_ (if any), so the service threads exit once the timers left to fire and the callbacks have run.
+    void StopEngine(const ShutdownPolicy policy, const std::chrono::steady_clock::time_point deadline)
+    {
+        while (submissions_.Drain([this](const Submission& submission) { ApplySubmission(submission); })) {
+        }
+        engine_stopped_ = true;
+
+        try {
+            std::vector<TimerNode*> nodes{};
+            nodes.reserve(index_.Size());
+            index_.ForEach([&nodes](uint64_t, TimerNode* node) { nodes.push_back(node); });
+            std::sort(nodes.begin(), nodes.end(), [](const TimerNode* a, const TimerNode* b) { return a->deadline_ < b->deadline_; });
+
+            for (TimerNode* node : nodes) {
+                const bool one_shot = node->period_.count() == 0;
+                if (policy == ShutdownPolicy::DrainUntilDeadline && one_shot && node->deadline_ <= deadline) {
+                    continue; // (Fires on time)
+                }
+
+                index_.Erase(node->timer_id_);
+                Disarm(node);
+                if (policy == ShutdownPolicy::FireDueNow && one_shot) {
+                    Expire(node);
+                } else {
+                    Release(node);
+                    ++shutdown_dropped_;
+                }
+            }
+        } catch (const std::exception& e) {
+            Report(SchedulerEventKind::EngineFailed, std::nullopt, e); // (Stopping the engine; the rest is dropped at the deadline)
+        }
+        active_timers_.store(index_.Size(), std::memory_order_relaxed);
+
+        if (index_.Empty()) {
+            wheel_timer_.cancel();
+            wheel_armed_tick_.reset();
+        }
+
+        io_service_work_.reset();
+    }
+
+    // Constructor (options, own_io_service, external_io_service, external_handler_memory)
+    //
+    // The public constructors delegate here, with either an io_service of the Scheduler's own (run by the threads started
+    // here) or the caller's io_context, and in that case optionally the caller's handler pool.
+    Scheduler(const SchedulerOptions& options, std::shared_ptr<boost::asio::io_service> own_io_service,
+        boost::asio::io_service* external_io_service, HandlerMemoryPool* external_handler_memory) :
+        options_(options),
+        runtime_(MakeRuntime(options)),
+        own_io_service_(std::move(own_io_service)),
+        handler_memory_(own_io_service_ ? &runtime_->handler_memory_ : external_handler_memory),
+        node_pool_(runtime_->node_pool_),
+        submissions_(SubmissionRingSlots(options, own_io_service_ != nullptr)),
+        io_service_(own_io_service_ ? *own_io_service_ : *external_io_service),
+        engine_strand_(boost::asio::make_strand(io_service_)),
+        callback_strands_(MakeCallbackStrands(options)),
+        wheel_epoch_(std::chrono::steady_clock::now()),
+        wheel_tick_(std::max(options.wheel_tick, std::chrono::nanoseconds(1))),
+        wheel_(options.engine == TimerEngine::TimingWheel ? std::make_unique<TimingWheel<TimerNode>>() : nullptr),
+        wheel_timer_(io_service_)
+    {
+        if (own_io_service_) { // (Otherwise, the caller's threads run io_service_)
+            io_service_work_.emplace(io_service_);
+            try {
+                io_service_thread_ = StartServiceThread(); // (Runs the function Service() asynchronously)
+                for (std::size_t i = 1; i < options.worker_threads; ++i) {
+                    worker_threads_.push_back(StartServiceThread());
+                }
+            } catch (...) {
+                io_service_.stop(); // (Lets the threads already started exit, so their jthread members can join)
+                throw;
+            }
+        }
+
+        if (runtime_->timer_store_) {
+            ReloadTimerStore();
+        }
+    }
+
+    // StartServiceThread()
+    //
+    // Starts a thread running Service(), sharing ownership of own_io_service_ and runtime_ (counted in live_threads_).
+    std::jthread StartServiceThread()
+    {
+        Runtime& runtime = *runtime_;
+        {
+            std::lock_guard lock(runtime.mutex_);
+            ++runtime.live_threads_;
+        }
+
+        try {
+            return std::jthread([io_service = own_io_service_, runtime = runtime_]() mutable {
+                Service(*io_service, *runtime);
+                io_service.reset(); // (If this thread was detached and is the last owner, the handlers go before runtime)
+                });
+        } catch (...) {
+            std::lock_guard lock(runtime.mutex_);
+            --runtime.live_threads_;
+            throw;
+        }
+    }
+
+    // Service(io_service, runtime)
+    //
+    // - Runs in the context of a dedicated thread (io_service_thread_, and each of worker_threads_).
+    // - Starts the Boost Asio io_service_ event loop, which is responsible for executing all scheduled asynchronous operations.
+    // - This function blocks until the io_service_ is stopped or runs out of work (see Shutdown()), or an error occurs.
+    // - Catches and reports any exceptions that occur during the io_service_ execution.
+    // - Static: a thread detached by Shutdown() gets here after the Scheduler may have been destroyed.
+    //
+    // Note: This function should not be called directly.
+    static void Service(boost::asio::io_service& io_service, Runtime& runtime)
+    {
+        try {
+            io_service.run(); // (Blocking)
+        } catch (const std::exception& e) {
+            Report(runtime, SchedulerEventKind::ThreadFailed, std::nullopt, e.what());
+        }
+
+        {
+            std::lock_guard lock(runtime.mutex_);
+            --runtime.live_threads_;
+        }
+        runtime.thread_exited_.notify_all();
+    }
+
+    // WaitForHandlers(deadline)
+    //
+    // Waits until the caller's io_context has run (or dropped) every handler of the Scheduler, or until `deadline` (external
+    // io_context only). Returns whether it got there; returns at once if the io_context cannot make progress while this
+    // thread waits (it runs on this thread, or is stopped).
+    bool WaitForHandlers(const std::chrono::steady_clock::time_point deadline) const
+    {
+        const auto settled = [this] { return runtime_.use_count() == 1; }; // (Only the Scheduler owns runtime_)
+        if (io_service_.get_executor().running_in_this_thread() || io_service_.stopped()) {
+            return settled();
+        }
+
+        while (!settled()) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        return true;
+    }
+
+    // options_: The configuration the Scheduler was constructed with.
+    const SchedulerOptions options_{};
+
+    // runtime_: The memory pools and the shutdown state, shared with the service threads and the handlers (see Runtime).
+    const std::shared_ptr<Runtime> runtime_;
+
+    // own_io_service_: The io_service the Scheduler runs on its own threads, shared with them; null on an external io_context.
+    // - Declared after runtime_, so the handlers it destroys go before the pools.
+    const std::shared_ptr<boost::asio::io_service> own_io_service_;
+
+    // Memory pools (in runtime_, so they outlive every handler, even one the io_service destroys or runs after the Scheduler):
+    // - handler_memory_: Operations Asio allocates for the Scheduler's post() and async_wait() calls. On an external
+    //                    io_context, the caller's pool (which it keeps alive as long as the io_context), if any; else null,
+    //                    and these come from the heap (see Pooled()).
+    // - node_pool_:      TimerNode blocks.
+    // In steady state, scheduling, cancelling and expiring a timer allocates nothing from the heap (on an external io_context
+    // without a handler pool, Asio's operations do).
+    HandlerMemoryPool* const handler_memory_;
+    FixedBlockPool& node_pool_;
+
+    // submissions_: Lock-free MPSC queue carrying the public API calls to engine_strand_, which drains it in batches.
+    // - Producers (any thread) never take a lock; the Asio strand and io_service_ queues see one post per drain, not per call.
+    // - Submissions still queued at destruction are discarded by the destructor (nodes returned to node_pool_).
+    SubmissionQueue<Submission> submissions_;
+
+    // io_service_: The core object from Boost Asio responsible for managing asynchronous operations within the Scheduler.
+    // - Handles the scheduling and execution of the timers.
+    // - Functions as the central event loop for the Scheduler's asynchronous activities.
+    // - Either *own_io_service_, or the caller's io_context (see Scheduler(io_context, options)).
+    boost::asio::io_service& io_service_;
+
+    // io_service_work_: Keeps *own_io_service_ running until StopEngine() lets it run out of work (empty on an external io_context).
+    std::optional<boost::asio::io_service::work> io_service_work_{};
+
+    // engine_strand_: Serializes all access to the timer index and the engines, whichever thread of the pool runs it.
+    Strand engine_strand_;
+
+    // callback_strands_: Strand pool for expired callbacks (empty when the Scheduler runs on a single thread).
+    const std::vector<Strand> callback_strands_;
+
+    // index_: timer_id -> pending timer node (engine_strand_ only). Backs CancelTimer() and RescheduleTimer().
+    TimerIndex<TimerNode> index_{};
+
+    // Instrumentation (see Stats()); written with relaxed atomics by the engine strand and the callback threads:
+    // - active_timers_:     index_.Size(), published by the engine strand after every change.
+    // - fired_:             Callback invocations.
+    // - cancelled_:         Timers cancelled or replaced.
+    // - suppressed_:        Debounce/Throttle calls superseded by a later call (see Upsert()).
+    // - pending_callbacks_: Callbacks posted to callback_strands_ that have not started.
+    // - wakeups_:           Engine wakeups (see SchedulerStats::wakeups).
+    // - lateness_:          Callback start minus deadline.
+    // - callback_runtime_:  Callback run time.
+    // - precision_lateness_, spin_time_: Precision mode only (see SchedulerStats).
+    std::atomic<uint64_t> active_timers_{ 0 };
+    std::atomic<uint64_t> fired_{ 0 };
+    std::atomic<uint64_t> cancelled_{ 0 };
+    std::atomic<uint64_t> suppressed_{ 0 };
+    std::atomic<uint64_t> pending_callbacks_{ 0 };
+    std::atomic<uint64_t> wakeups_{ 0 };
+    LatencyHistogram lateness_{};
+    LatencyHistogram callback_runtime_{};
+    LatencyHistogram precision_lateness_{};
+    LatencyHistogram spin_time_{};
+
+    // asio_nodes_: The AsioTimer engine's nodes that are pending or still have a handler in flight (engine_strand_ only).
+    TimingWheelList asio_nodes_{};
+
+    // TimingWheel engine state (engine_strand_ only):
+    // - wheel_epoch_:      The time point of wheel tick 0.
+    // - wheel_tick_:       The duration of one wheel tick.
+    // - wheel_:            The pending timers (owns the nodes linked into it; disposed of by the destructor). Allocated
+    //                      with the TimingWheel engine only (its slots take about 24 KB).
+    // - wheel_timer_:      The single timer that advances the wheel (see WheelTimer).
+    // - wheel_armed_tick_: The tick wheel_timer_ is currently armed for, if any.
+    const std::chrono::steady_clock::time_point wheel_epoch_{};
+    const std::chrono::nanoseconds wheel_tick_{};
+    const std::unique_ptr<TimingWheel<TimerNode>> wheel_{};
+    WheelTimer wheel_timer_;
+    std::optional<uint64_t> wheel_armed_tick_{};
+
+    // Timer coalescing state (engine_strand_ only; see CoalescedExpiry()):
+    // - kCoalesceTarget:   Timers per window at which the adaptive window reaches the full slack.
+    // - kArmRateInterval:  Averaging period of the arm rate.
+    // - arms_since_:       Timers armed since arm_rate_since_.
+    // - arm_rate_:         Moving average of timers armed per second.
+    // - last_asio_expiry_: The expiry of the last AsioTimer node expired (for counting wakeups).
+    // - expiring_:         Nodes to expire as one batch, in deadline order (see ExpireInBatch() and OnWheelTimer()).
+    static constexpr double kCoalesceTarget = 4.0;
+    static constexpr std::chrono::milliseconds kArmRateInterval{ 50 };
+    uint64_t arms_since_{ 0 };
+    std::chrono::steady_clock::time_point arm_rate_since_{ std::chrono::steady_clock::now() };
+    double arm_rate_{ 0.0 };
+    std::chrono::steady_clock::time_point last_asio_expiry_{};
+    std::vector<ExpiringNode> expiring_{};
+
+    // Shutdown state (see Shutdown()):
+    // - shutting_down_:       Set by the first Shutdown() call; new timers are refused from then on.
+    // - engine_stopped_:      StopEngine() has run (engine_strand_ only).
+    // - shutdown_dropped_:    Timers dropped by StopEngine() (engine_strand_ only).
+    // - callbacks_in_flight_: Shutdown() gave up on threads still inside callbacks (see ShutdownReport::in_flight).
+    std::atomic<bool> shutting_down_{ false };
+    bool engine_stopped_{ false };
+    uint64_t shutdown_dropped_{ 0 };
+    bool callbacks_in_flight_{ false };
+
+    // next_sleep_id_: The timer id of the next SleepFor() / SleepUntil() wait.
+    std::atomic<uint64_t> next_sleep_id_{ kSleepTimerIdBase };
+
+    // io_service_thread_: Thread for running io_service_ event loop, separate from the Scheduler's creation thread (none on
+    // an external io_context).
+    // - This prevents blocking of the creating thread and ensures responsiveness.
+    // - It enables concurrent handling of asynchronous operations alongside other tasks in the program.
+    std::jthread io_service_thread_{};
+
+    // worker_threads_: Additional threads running the io_service_ event loop (SchedulerOptions::worker_threads - 1).
+    std::vector<std::jthread> worker_threads_{};
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,490 @@
+#ifndef AMITG_FC_SHARDED_SCHEDULER
+#define AMITG_FC_SHARDED_SCHEDULER
+
+/*
+    ShardedScheduler.h
+    Copyright (c) 2024, Amit Gefen
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+#if defined(_WIN32)
+#if !defined(WIN32_LEAN_AND_MEAN)
+#define WIN32_LEAN_AND_MEAN // (Keeps out winsock.h, which Asio's winsock2.h conflicts with)
+#endif
+#if !defined(NOMINMAX)
+#define NOMINMAX // (Keeps std::min() and std::max() usable)
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "Scheduler.h"
+
+
+// ShardedSchedulerOptions: Construction-time configuration of a ShardedScheduler.
+struct ShardedSchedulerOptions
+{
+    // shards: Number of shards, each a timer engine with a thread of its own (0: one per hardware thread).
+    std::size_t shards{ 0 };
+
+    // cpus: The CPU each shard's thread is pinned to; shard i runs on cpus[i % cpus.size()] (empty: shard i on CPU i).
+    std::vector<unsigned> cpus{};
+
+    // pin_threads: Pin the shard threads to their CPUs (see PinThisThread()).
+    bool pin_threads{ true };
+
+    // scheduler: The options of each shard's Scheduler. worker_threads is ignored: a shard runs on exactly one thread.
+    //            timer_store is not supported (the shards would share one log file).
+    SchedulerOptions scheduler{};
+};
+
+
+// PinThisThread(cpu)
+//
+// Restricts the calling thread to one CPU. Returns false if that fails, or is not supported on this platform (e.g., macOS,
+// which has no hard affinity).
+inline bool PinThisThread(const unsigned cpu)
+{
+#if defined(_WIN32)
+    return cpu < 64 && SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{ 1 } << cpu) != 0;
+#elif defined(__linux__)
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+
+// ShardedScheduler
+//
+// Thread-per-core timer scheduling: one Scheduler per shard, each attached to an io_context that a thread of its own runs,
+// pinned to one CPU. Every timer_id is routed to a shard by hash, so all the calls for a given timer (schedule, cancel,
+// reschedule) reach the same timer engine through that shard's lock-free submission queue; there is no global lock.
+// - A shard is created on its own thread after pinning it, so the memory it allocates for itself (the Scheduler, its timer
+//   index and engine, the io_context) is first touched on the CPU that uses it: NUMA-local under the default first-touch
+//   policy. Timer nodes are allocated by the scheduling thread, like with a single Scheduler.
+// - Callbacks run on the owning shard's thread; a callback that blocks delays only the timers of its shard.
+// - Per-shard counters (ShardStats()) show hot shards; Stats() adds them up.
+
+class ShardedScheduler final
+{
+public:
+
+    // Constructor (options)
+    //
+    // Starts `options.shards` threads, each pinned to its CPU (see ShardedSchedulerOptions), and creates a shard on each.
+    //
+    // Throws:
+    //   - Any standard exceptions that might occur during thread creation or shard initialization (the shards already
+    //     started are shut down first).
+    //   - std::invalid_argument if `options.scheduler` has a timer store.
+    explicit ShardedScheduler(const ShardedSchedulerOptions& options = ShardedSchedulerOptions{}) :
+        options_(options),
+        event_sink_(options.scheduler.event_sink ? options.scheduler.event_sink : DefaultEventSink())
+    {
+        if (!options.scheduler.timer_store.path.empty()) {
+            throw std::invalid_argument("a ShardedScheduler does not support a timer store");
+        }
+
+        const std::size_t hardware_threads = std::max(std::thread::hardware_concurrency(), 1u);
+        const std::size_t count = options.shards > 0 ? options.shards : hardware_threads;
+
+        SchedulerOptions scheduler_options = options.scheduler;
+        scheduler_options.worker_threads = 1;
+        scheduler_options.event_sink = event_sink_;
+        if (scheduler_options.submission_queue_capacity == 0) {
+            scheduler_options.submission_queue_capacity = 1024; // (A shard has a thread of its own, like a standalone Scheduler)
+        }
+
+        try {
+            shards_.reserve(count);
+            threads_.reserve(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                const unsigned cpu = options.cpus.empty() ? static_cast<unsigned>(i % hardware_threads) : options.cpus[i % options.cpus.size()];
+                StartShard(cpu, scheduler_options);
+            }
+        } catch (...) {
+            ShutdownShards(ShutdownPolicy::CancelAll, std::chrono::steady_clock::now());
+            throw;
+        }
+    }
+
+    ShardedScheduler(const ShardedScheduler&) = delete;
+    ShardedScheduler& operator=(const ShardedScheduler&) = delete;
+
+    // Destructor
+    //
+    // - Shuts every shard down with SchedulerOptions::shutdown_policy (of `options.scheduler`), unless Shutdown() was called
+    //   before, within SchedulerOptions::shutdown_timeout in total.
+    // - Catches and reports any potential exceptions that occur during the shutdown (see SchedulerOptions::event_sink).
+    ~ShardedScheduler()
+    {
+        try {
+            Shutdown(options_.scheduler.shutdown_policy, options_.scheduler.shutdown_timeout);
+        } catch (const std::exception& e) {
+            event_sink_->Publish(MakeSchedulerEvent(SchedulerEventKind::ShutdownFailed, std::nullopt, e.what()));
+        }
+    }
+
+    // ScheduleTimer(timer_id, duration, callback, callback_args...)
+    // ScheduleTimer(timer_id, duration, member_function, instance, member_function_args...)
+    //
+    // Schedules a timer on the shard that owns `timer_id` (see Scheduler::ScheduleTimer()).
+    template <typename... Args>
+    void ScheduleTimer(const uint64_t timer_id, Args&&... args)
+    {
+        ShardFor(timer_id).ScheduleTimer(timer_id, std::forward<Args>(args)...);
+    }
+
+    // SchedulePeriodic(timer_id, period, [catch_up,] callback, callback_args...)
+    //
+    // Schedules a periodic timer on the shard that owns `timer_id` (see Scheduler::SchedulePeriodic()).
+    template <typename... Args>
+    void SchedulePeriodic(const uint64_t timer_id, Args&&... args)
+    {
+        ShardFor(timer_id).SchedulePeriodic(timer_id, std::forward<Args>(args)...);
+    }
+
+    // ScheduleIdleTimeout(timer_id, timeout, callback, callback_args...)
+    //
+    // Schedules an idle timeout on the shard that owns `timer_id`, and returns its handle (see
+    // Scheduler::ScheduleIdleTimeout()). Touching it does not involve the shard.
+    template <typename... Args>
+    IdleTimeout ScheduleIdleTimeout(const uint64_t timer_id, Args&&... args)
+    {
+        return ShardFor(timer_id).ScheduleIdleTimeout(timer_id, std::forward<Args>(args)...);
+    }
+
+    // Debounce(timer_id, delay, callback_or_member_function, args...)
+    // Throttle(timer_id, interval, callback_or_member_function, args...)
+    //
+    // Debounces or throttles `timer_id` on the shard that owns it, so every call with the same key meets the same pending
+    // timer (see Scheduler::Debounce(), Scheduler::Throttle()).
+    template <typename... Args>
+    void Debounce(const uint64_t timer_id, Args&&... args)
+    {
+        ShardFor(timer_id).Debounce(timer_id, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void Throttle(const uint64_t timer_id, Args&&... args)
+    {
+        ShardFor(timer_id).Throttle(timer_id, std::forward<Args>(args)...);
+    }
+
+    // ScheduleTimerCompletion(timer_id, duration, callback, callback_args...)
+    //
+    // Schedules a timer on the shard that owns `timer_id`, and returns its completion handle (see
+    // Scheduler::ScheduleTimerCompletion()).
+    template <typename... Args>
+    decltype(auto) ScheduleTimerCompletion(const uint64_t timer_id, Args&&... args)
+    {
+        return ShardFor(timer_id).ScheduleTimerCompletion(timer_id, std::forward<Args>(args)...);
+    }
+
+    // CancelTimer(timer_id)
+    //
+    // Cancels a pending timer on the shard that owns it (see Scheduler::CancelTimer()).
+    void CancelTimer(const uint64_t timer_id)
+    {
+        ShardFor(timer_id).CancelTimer(timer_id);
+    }
+
+    // RescheduleTimer(timer_id, new_duration)
+    //
+    // Moves a pending timer on the shard that owns it (see Scheduler::RescheduleTimer()).
+    void RescheduleTimer(const uint64_t timer_id, const TimerDeadline new_duration)
+    {
+        ShardFor(timer_id).RescheduleTimer(timer_id, new_duration);
+    }
+
+    // ScheduleTimers(specs, callback, callback_args...)
+    // ScheduleTimers(specs, member_function, instance, member_function_args...)
+    //
+    // Splits a batch by shard, and hands each shard its part as one batch (see Scheduler::ScheduleTimers()).
+    template <typename... Args>
+    void ScheduleTimers(const std::span<const TimerSpec> specs, const Args&... args)
+    {
+        ForEachShardBatch(specs, [](const TimerSpec& spec) { return spec.timer_id; },
+            [&args...](Scheduler& shard, const std::span<const TimerSpec> batch) { shard.ScheduleTimers(batch, args...); });
+    }
+
+    // CancelTimers(timer_ids)
+    //
+    // Splits a batch of cancellations by shard (see Scheduler::CancelTimers()).
+    void CancelTimers(const std::span<const uint64_t> timer_ids)
+    {
+        ForEachShardBatch(timer_ids, [](const uint64_t timer_id) { return timer_id; },
+            [](Scheduler& shard, const std::span<const uint64_t> batch) { shard.CancelTimers(batch); });
+    }
+
+    // Shutdown(policy, timeout)
+    //
+    // Shuts every shard down (see Scheduler::Shutdown()) within `timeout` in total, and returns the sum of their reports.
+    // - The shards are shut down concurrently, against one common deadline.
+    // - A shard thread still inside a callback at the deadline is detached; it exits as soon as the callback returns.
+    // - Only the first call does anything; later calls return an empty report. Must not be called from a callback.
+    ShutdownReport Shutdown(const ShutdownPolicy policy, const TimerDuration timeout)
+    {
+        if (shut_down_.exchange(true)) {
+            return {};
+        }
+        return ShutdownShards(policy, std::chrono::steady_clock::now() + timeout.Get());
+    }
+
+    // ShardCount(): The number of shards.
+    std::size_t ShardCount() const noexcept { return shards_.size(); }
+
+    // ShardOf(timer_id): The index of the shard that owns `timer_id`.
+    std::size_t ShardOf(const uint64_t timer_id) const noexcept
+    {
+        return static_cast<std::size_t>(MixTimerKey(timer_id) % shards_.size());
+    }
+
+    // Shard(index): The Scheduler of a shard, e.g., for SleepFor() or Spawn() on the shard a coroutine belongs to.
+    Scheduler& Shard(const std::size_t index) noexcept { return shards_[index]->scheduler_; }
+
+    // ShardStats()
+    //
+    // Returns a snapshot of each shard's counters and latency histograms (see Scheduler::Stats()), indexed by shard. A shard
+    // with many more active timers, a deeper submission queue or a later lateness percentile than the others is hot.
+    std::vector<SchedulerStats> ShardStats() const
+    {
+        std::vector<SchedulerStats> stats{};
+        stats.reserve(shards_.size());
+        for (const auto& shard : shards_) {
+            stats.push_back(shard->scheduler_.Stats());
+        }
+        return stats;
+    }
+
+    // Stats()
+    //
+    // Returns the shards' counters added up, and their histograms merged (largest_drain is the largest of any shard).
+    SchedulerStats Stats() const
+    {
+        SchedulerStats total{};
+        for (const SchedulerStats& stats : ShardStats()) {
+            total.active_timers += stats.active_timers;
+            total.fired += stats.fired;
+            total.cancelled += stats.cancelled;
+            total.suppressed += stats.suppressed;
+            total.queue_depth += stats.queue_depth;
+            total.pending_callbacks += stats.pending_callbacks;
+            total.wakeups += stats.wakeups;
+            total.callback_errors += stats.callback_errors;
+            total.submissions.submissions += stats.submissions.submissions;
+            total.submissions.cas_retries += stats.submissions.cas_retries;
+            total.submissions.overflows += stats.submissions.overflows;
+            total.submissions.drains += stats.submissions.drains;
+            total.submissions.largest_drain = std::max(total.submissions.largest_drain, stats.submissions.largest_drain);
+            total.submissions.depth += stats.submissions.depth;
+            total.lateness.Merge(stats.lateness);
+            total.callback_runtime.Merge(stats.callback_runtime);
+            total.precision_lateness.Merge(stats.precision_lateness);
+            total.spin_time.Merge(stats.spin_time);
+        }
+        return total;
+    }
+
+private:
+
+    // ShardContext: One timer engine, created on (and run by) its own pinned thread.
+    // - Shared between the ShardedScheduler and that thread, so a thread detached by Shutdown() can finish its callback and
+    //   exit after the ShardedScheduler is gone.
+    // - handler_memory_: The pool of the Asio operations of scheduler_, as with a standalone Scheduler's own io_service.
+    //   Declared before io_context_, so it outlives the operations the io_context frees on destruction.
+    struct ShardContext final
+    {
+        explicit ShardContext(const SchedulerOptions& options) : scheduler_(io_context_, handler_memory_, options)
+        {
+        }
+
+        HandlerMemoryPool handler_memory_{};
+        boost::asio::io_context io_context_{ 1 };
+        boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work_{ io_context_.get_executor() };
+        Scheduler scheduler_;
+    };
+
+    // StartShard(cpu, options)
+    //
+    // Starts a shard thread, pinned to `cpu`, and waits until it has created its shard.
+    void StartShard(const unsigned cpu, const SchedulerOptions& options)
+    {
+        std::promise<std::shared_ptr<ShardContext>> created{};
+        std::future<std::shared_ptr<ShardContext>> shard = created.get_future();
+
+        std::jthread thread([created = std::move(created), cpu, options, pin = options_.pin_threads]() mutable {
+            std::shared_ptr<ShardContext> shard{};
+            try {
+                if (pin && !PinThisThread(cpu)) {
+                    options.event_sink->Publish(MakeSchedulerEvent(SchedulerEventKind::PinFailed, std::nullopt, "cpu " + std::to_string(cpu)));
+                }
+                shard = std::make_shared<ShardContext>(options); // (First touched on this CPU)
+                created.set_value(shard);
+            } catch (...) {
+                created.set_exception(std::current_exception());
+                return;
+            }
+            RunShard(*shard, *options.event_sink);
+            });
+
+        try {
+            shards_.push_back(shard.get());
+        } catch (...) {
+            thread.join(); // (The shard was not created, so the thread has exited)
+            throw;
+        }
+        threads_.push_back(std::move(thread));
+    }
+
+    // RunShard(shard, event_sink)
+    //
+    // - Runs in the context of a shard thread, until the shard is shut down (see ShutdownShards()).
+    // - Catches and reports any exceptions that occur during the io_context execution.
+    static void RunShard(ShardContext& shard, SchedulerEventSink& event_sink)
+    {
+        try {
+            shard.io_context_.run(); // (Blocking)
+        } catch (const std::exception& e) {
+            event_sink.Publish(MakeSchedulerEvent(SchedulerEventKind::ThreadFailed, std::nullopt, e.what()));
+        }
+    }
+
+    // ShutdownShards(policy, deadline)
+    //
+    // Shuts down the shards started so far, all at once (each on a thread of its own), so a shard stuck in a callback does
+    // not eat into the time of the others; then stops their threads.
+    ShutdownReport ShutdownShards(const ShutdownPolicy policy, const std::chrono::steady_clock::time_point deadline)
+    {
+        std::vector<ShutdownReport> reports(threads_.size());
+        const auto shut_down = [this, &reports, policy, deadline](const std::size_t i) {
+            const auto left = std::max(deadline - std::chrono::steady_clock::now(), std::chrono::steady_clock::duration::zero());
+            reports[i] = shards_[i]->scheduler_.Shutdown(policy, left);
+            };
+
+        {
+            std::vector<std::jthread> shutdowns{};
+            for (std::size_t i = 0; i < reports.size(); ++i) {
+                try {
+                    shutdowns.emplace_back(shut_down, i);
+                } catch (const std::system_error&) {
+                    shut_down(i); // (No thread to spare; on this one)
+                }
+            }
+        }
+
+        ShutdownReport total{};
+        for (std::size_t i = 0; i < reports.size(); ++i) {
+            total.dropped += reports[i].dropped;
+            total.fired += reports[i].fired;
+            total.in_flight += reports[i].in_flight;
+            total.timed_out = total.timed_out || reports[i].timed_out;
+
+            // Nothing of the shard runs any more (its handlers return at once), even if timers were left pending:
+            shards_[i]->io_context_.stop();
+            if (reports[i].in_flight == 0) {
+                threads_[i].join();
+            } else {
+                threads_[i].detach(); // (Exits as soon as its callback returns)
+            }
+        }
+        return total;
+    }
+
+    // ShardFor(timer_id): The Scheduler of the shard that owns `timer_id`.
+    Scheduler& ShardFor(const uint64_t timer_id) noexcept
+    {
+        return shards_[ShardOf(timer_id)]->scheduler_;
+    }
+
+    // ForEachShardBatch(items, timer_id_of, submit)
+    //
+    // Groups `items` by the shard that owns their timer ids (keeping their order), and calls submit(shard, batch) once for
+    // each shard that has any.
+    // - A counting sort into one buffer: each shard's batch is a contiguous slice of it.
+    // - The buffers are per thread and reused, so routing a batch allocates only when it is larger than any before it on
+    //   the calling thread. (submit() only hands the batch to a submission queue; it does not route batches itself)
+    template <typename Item, typename TimerIdOf, typename Submit>
+    void ForEachShardBatch(const std::span<const Item> items, const TimerIdOf& timer_id_of, const Submit& submit)
+    {
+        thread_local std::vector<std::size_t> ends{};  // (By shard; counts, then where each shard's slice ends)
+        thread_local std::vector<std::size_t> order{}; // (Indices into `items`, grouped by shard)
+        thread_local std::vector<Item> grouped{};
+
+        ends.assign(shards_.size(), 0);
+        for (const Item& item : items) {
+            ++ends[ShardOf(timer_id_of(item))];
+        }
+        std::size_t offset = 0;
+        for (std::size_t& end : ends) {
+            end = std::exchange(offset, offset + end); // (Where the shard's slice begins, for now)
+        }
+
+        order.resize(items.size());
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            order[ends[ShardOf(timer_id_of(items[i]))]++] = i; // (Leaves ends[shard] at the end of its slice)
+        }
+        grouped.clear();
+        for (const std::size_t i : order) {
+            grouped.push_back(items[i]);
+        }
+
+        for (std::size_t i = 0; i < ends.size(); ++i) {
+            const std::size_t begin = i == 0 ? 0 : ends[i - 1];
+            if (ends[i] > begin) {
+                submit(shards_[i]->scheduler_, std::span<const Item>(grouped).subspan(begin, ends[i] - begin));
+            }
+        }
+    }
+
+    // options_: The configuration the ShardedScheduler was constructed with.
+    const ShardedSchedulerOptions options_{};
+
+    // event_sink_: The event sink of the ShardedScheduler and of its shards (see SchedulerOptions::event_sink).
+    const std::shared_ptr<SchedulerEventSink> event_sink_{};
+
+    // shards_:  The shards, indexed by ShardOf(); shared with their threads (see ShardContext).
+    // threads_: The shard threads, in the same order (joined by Shutdown(), or detached if stuck in a callback).
+    std::vector<std::shared_ptr<ShardContext>> shards_{};
+    std::vector<std::jthread> threads_{};
+
+    // shut_down_: Shutdown() was called.
+    std::atomic<bool> shut_down_{ false };
+};
+
+#endif
@@ -0,0 +1,294 @@
+#ifndef AMITG_FC_SUBMISSION_QUEUE
+#define AMITG_FC_SUBMISSION_QUEUE
+
+/*
+    SubmissionQueue.h
+    Copyright (c) 2024, Amit Gefen
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include "TimerPool.h"
+
+
+// SubmissionQueueStats: Counters of a SubmissionQueue (a relaxed snapshot; each counter is individually consistent).
+// - submissions:   Items pushed.
+// - cas_retries:   Times a producer lost the race for a ring slot to another producer and had to retry.
+// - overflows:     Items that found the ring full (or not yet drained of earlier overflows) and took the overflow list.
+// - drains:        Drain() calls that found at least one item.
+// - largest_drain: The most items a single Drain() call processed.
+// - depth:         Items pushed but not consumed yet.
+struct SubmissionQueueStats
+{
+    uint64_t submissions{ 0 };
+    uint64_t cas_retries{ 0 };
+    uint64_t overflows{ 0 };
+    uint64_t drains{ 0 };
+    uint64_t largest_drain{ 0 };
+    uint64_t depth{ 0 };
+};
+
+
+// SubmissionQueue<T>
+//
+// Lock-free multi-producer / single-consumer queue of trivially copyable items, drained in batches.
+// - A bounded ring (Vyukov): a producer claims a slot with one CAS on the enqueue position and publishes it with a release
+//   store of the slot's sequence number. No mutex, and producers never wait for the consumer.
+// - When the ring is full, items go to an unbounded overflow list (a lock-free stack of nodes from a FixedBlockPool, so a
+//   recurring burst allocates nothing once the pool has grown). Producers keep using the overflow list until the consumer
+//   has taken it, so the items of any one producer (and causally ordered pushes from different producers) drain in order.
+// - Push() reports whether the caller has to schedule a drain (exactly one drain is scheduled at a time).
+
+template <typename T>
+class SubmissionQueue final
+{
+    static_assert(std::is_trivially_copyable_v<T>, "SubmissionQueue items must be trivially copyable");
+
+public:
+
+    // Constructor
+    //
+    // - `capacity`: Number of ring slots, rounded up to a power of two.
+    explicit SubmissionQueue(const std::size_t capacity) :
+        mask_(RoundUpToPowerOfTwo(capacity) - 1),
+        cells_(std::make_unique<Cell[]>(mask_ + 1))
+    {
+        for (std::size_t i = 0; i <= mask_; ++i) {
+            cells_[i].sequence_.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    SubmissionQueue(const SubmissionQueue&) = delete;
+    SubmissionQueue& operator=(const SubmissionQueue&) = delete;
+
+    ~SubmissionQueue()
+    {
+        OverflowNode* node = overflow_.exchange(nullptr, std::memory_order_acquire);
+        while (node != nullptr) {
+            overflow_pool_.Deallocate(std::exchange(node, node->next_));
+        }
+    }
+
+    // Push(item)
+    //
+    // Enqueues `item` (any thread). Returns true if the queue was idle, in which case the caller schedules a Drain().
+    //
+    // Throws:
+    //   - std::bad_alloc if the ring is full and the overflow pool cannot grow (the item is not enqueued).
+    bool Push(const T& item)
+    {
+        if (overflow_.load(std::memory_order_acquire) != nullptr || !TryPushRing(item)) {
+            PushOverflow(item);
+        }
+
+        return !drain_scheduled_.exchange(true, std::memory_order_acq_rel);
+    }
+
+    // TryPush(item)
+    //
+    // Enqueues `item` into the ring only (any thread; never allocates). Returns std::nullopt if the ring is full, in which
+    // case the item is not enqueued, or else whether the caller schedules a Drain() (as Push()). For queues that drop items
+    // rather than grow.
+    std::optional<bool> TryPush(const T& item) noexcept
+    {
+        if (overflow_.load(std::memory_order_acquire) != nullptr || !TryPushRing(item)) {
+            return std::nullopt;
+        }
+
+        return !drain_scheduled_.exchange(true, std::memory_order_acq_rel);
+    }
+
+    // Drain(consume)
+    //
+    // Invokes `consume(item)` for queued items, in push order (consumer only).
+    // - Consumes at most one ring's worth of items per call, so a steady stream of pushes cannot monopolize the consumer.
+    //   Returns true if items were left for another call, in which case the caller schedules it.
+    // - Items pushed while Drain() runs are either consumed by it, or reported by their Push() as needing a new drain.
+    // - `consume` must not throw (it owns whatever the item refers to from the moment it is called).
+    template <typename Consume>
+    bool Drain(Consume&& consume)
+    {
+        // (An RMW, so it synchronizes with the Push() calls that found a drain already scheduled: their items are visible below.)
+        drain_scheduled_.exchange(false, std::memory_order_acq_rel);
+
+        std::size_t count = 0;
+
+        // The ring first, then the overflow list (everything in it was pushed after the ring items of the same producer):
+        T item;
+        while (count <= mask_ && TryPopRing(item)) {
+            consume(item);
+            ++count;
+        }
+
+        if (count > mask_) {
+            CountDrain(count);
+            return !drain_scheduled_.exchange(true, std::memory_order_acq_rel);
+        }
+
+        if (OverflowNode* stack = overflow_.exchange(nullptr, std::memory_order_acq_rel)) {
+            // The stack is LIFO; reverse it to restore push order:
+            OverflowNode* fifo = nullptr;
+            while (stack != nullptr) {
+                OverflowNode* next = stack->next_;
+                stack->next_ = fifo;
+                fifo = stack;
+                stack = next;
+            }
+
+            while (fifo != nullptr) {
+                OverflowNode* node = std::exchange(fifo, fifo->next_);
+                consume(node->item_);
+                overflow_pool_.Deallocate(node);
+                ++count;
+            }
+        }
+
+        CountDrain(count);
+        return false;
+    }
+
+    // AbortDrain()
+    //
+    // Lets the next Push() schedule a drain again, after the caller failed to schedule the one its Push() asked for.
+    void AbortDrain() noexcept
+    {
+        drain_scheduled_.store(false, std::memory_order_release);
+    }
+
+    SubmissionQueueStats Stats() const noexcept
+    {
+        SubmissionQueueStats stats{};
+        const uint64_t consumed = consumed_.load(std::memory_order_relaxed); // (Read first: never ahead of the pushes below)
+        stats.overflows = overflows_.load(std::memory_order_relaxed);
+        stats.submissions = enqueue_position_.load(std::memory_order_relaxed) + stats.overflows;
+        stats.cas_retries = cas_retries_.load(std::memory_order_relaxed);
+        stats.drains = drains_.load(std::memory_order_relaxed);
+        stats.largest_drain = largest_drain_.load(std::memory_order_relaxed);
+        stats.depth = stats.submissions - consumed;
+        return stats;
+    }
+
+private:
+
+    static constexpr std::size_t kCacheLine = 64;
+
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence_{ 0 };
+        T item_{};
+    };
+
+    struct OverflowNode
+    {
+        T item_;
+        OverflowNode* next_{ nullptr };
+    };
+
+    static std::size_t RoundUpToPowerOfTwo(const std::size_t value) noexcept
+    {
+        std::size_t power = 2;
+        while (power < value) {
+            power <<= 1;
+        }
+        return power;
+    }
+
+    void CountDrain(const std::size_t count) noexcept
+    {
+        if (count > 0) {
+            consumed_.store(consumed_.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+            drains_.fetch_add(1, std::memory_order_relaxed);
+            if (count > largest_drain_.load(std::memory_order_relaxed)) {
+                largest_drain_.store(count, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool TryPushRing(const T& item) noexcept
+    {
+        std::size_t position = enqueue_position_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[position & mask_];
+            const std::size_t sequence = cell.sequence_.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+
+            if (difference == 0) {
+                if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.item_ = item;
+                    cell.sequence_.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+                cas_retries_.fetch_add(1, std::memory_order_relaxed); // (Slow path only)
+            } else if (difference < 0) {
+                return false; // (Full)
+            } else {
+                position = enqueue_position_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool TryPopRing(T& item) noexcept
+    {
+        Cell& cell = cells_[dequeue_position_ & mask_];
+        const std::size_t sequence = cell.sequence_.load(std::memory_order_acquire);
+        if (static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(dequeue_position_ + 1) < 0) {
+            return false; // (Empty, or the next slot is claimed but not yet published)
+        }
+
+        item = cell.item_;
+        cell.sequence_.store(dequeue_position_ + mask_ + 1, std::memory_order_release);
+        ++dequeue_position_;
+        return true;
+    }
+
+    void PushOverflow(const T& item)
+    {
+        auto* node = ::new (overflow_pool_.Allocate()) OverflowNode{ item };
+        node->next_ = overflow_.load(std::memory_order_relaxed);
+        while (!overflow_.compare_exchange_weak(node->next_, node, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+        overflows_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const std::size_t mask_;
+    const std::unique_ptr<Cell[]> cells_;
+    FixedBlockPool overflow_pool_{ sizeof(OverflowNode), 256 };
+
+    // Producer side:
+    alignas(kCacheLine) std::atomic<std::size_t> enqueue_position_{ 0 };
+    alignas(kCacheLine) std::atomic<OverflowNode*> overflow_{ nullptr };
+    alignas(kCacheLine) std::atomic<bool> drain_scheduled_{ false };
+    std::atomic<uint64_t> cas_retries_{ 0 };
+    std::atomic<uint64_t> overflows_{ 0 };
+
+    // Consumer side:
+    alignas(kCacheLine) std::size_t dequeue_position_{ 0 };
+    std::atomic<uint64_t> consumed_{ 0 };
+    std::atomic<uint64_t> drains_{ 0 };
+    std::atomic<uint64_t> largest_drain_{ 0 };
+};
+
+#endif
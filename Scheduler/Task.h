@@ -0,0 +1,296 @@
+#ifndef AMITG_FC_TASK
+#define AMITG_FC_TASK
+
+/*
+    Task.h
+    Copyright (c) 2024, Amit Gefen
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+
+template <typename T = void>
+class Task;
+
+
+// TaskPromiseBase: The part of a Task's promise that does not depend on its result type.
+// - Tasks are lazy: a Task starts when it is awaited (or spawned), and resumes its awaiter when it completes
+//   (symmetric transfer, so long chains of co_await do not grow the stack).
+// - continuation_: The coroutine awaiting this one (a no-op coroutine until it is awaited).
+// - root_:         The self-owning coroutine at the bottom of the await chain (see DetachedTask), or null if the chain is
+//                  owned by someone else. Destroying the root destroys the whole chain.
+// - exception_:    The exception the task ended with, rethrown to its awaiter.
+class TaskPromiseBase
+{
+public:
+
+    // FinalAwaiter: Resumes the continuation of a completed task.
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(const std::coroutine_handle<Promise> completed) const noexcept
+        {
+            return completed.promise().continuation_;
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+
+    void unhandled_exception() noexcept { exception_ = std::current_exception(); }
+
+    std::coroutine_handle<> continuation_{ std::noop_coroutine() };
+    std::coroutine_handle<> root_{};
+
+protected:
+
+    void RethrowIfFailed() const
+    {
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+    }
+
+    std::exception_ptr exception_{};
+};
+
+
+// TaskPromise<T>: The promise of a Task<T> (stores the co_returned value).
+template <typename T>
+class TaskPromise final : public TaskPromiseBase
+{
+public:
+
+    Task<T> get_return_object() noexcept;
+
+    template <typename Value>
+    void return_value(Value&& value) { value_.emplace(std::forward<Value>(value)); }
+
+    T Result()
+    {
+        RethrowIfFailed();
+        return std::move(*value_);
+    }
+
+private:
+
+    std::optional<T> value_{};
+};
+
+template <>
+class TaskPromise<void> final : public TaskPromiseBase
+{
+public:
+
+    Task<void> get_return_object() noexcept;
+
+    void return_void() const noexcept {}
+
+    void Result() const { RethrowIfFailed(); }
+};
+
+
+// Task<T>
+//
+// The return type of a coroutine that produces a T (or nothing) and may co_await other Tasks and Scheduler::SleepFor() /
+// Scheduler::SleepUntil().
+// - Lazy and move-only: the coroutine starts when the Task is co_awaited, or handed to Scheduler::Spawn(), and the Task
+//   owns its frame (destroyed with the Task).
+// - `co_await task` (on an rvalue) returns the co_returned value, or rethrows the exception the coroutine ended with.
+// - Not synchronized: a Task is awaited once, by one coroutine.
+
+template <typename T>
+class Task final
+{
+public:
+
+    using promise_type = TaskPromise<T>;
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr))
+    {
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    Task& operator=(Task&&) = delete;
+
+    ~Task()
+    {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    // Awaiter: Starts the task, which resumes the awaiting coroutine when it completes (and joins its chain's root).
+    struct Awaiter
+    {
+        std::coroutine_handle<promise_type> handle_;
+
+        bool await_ready() const noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(const std::coroutine_handle<Promise> awaiting) const noexcept
+        {
+            handle_.promise().continuation_ = awaiting;
+            if constexpr (std::is_base_of_v<TaskPromiseBase, Promise>) {
+                handle_.promise().root_ = awaiting.promise().root_;
+            }
+            return handle_;
+        }
+
+        T await_resume() const { return handle_.promise().Result(); }
+    };
+
+    Awaiter operator co_await() && noexcept { return Awaiter{ handle_ }; }
+
+private:
+
+    friend class TaskPromise<T>;
+
+    explicit Task(const std::coroutine_handle<promise_type> handle) noexcept : handle_(handle)
+    {
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept
+{
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept
+{
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+
+// DetachedTask
+//
+// A self-owning coroutine (the root of a spawned await chain; see Scheduler::Spawn()).
+// - Created suspended; Release() hands its handle over, to be resumed (or destroyed, if it never runs) exactly once.
+// - Its frame is freed when the coroutine completes, or when its root handle is destroyed while it waits.
+// - The coroutine body must not let an exception escape (std::terminate).
+
+class DetachedTask final
+{
+public:
+
+    class promise_type final : public TaskPromiseBase
+    {
+    public:
+
+        DetachedTask get_return_object() noexcept
+        {
+            root_ = std::coroutine_handle<promise_type>::from_promise(*this);
+            return DetachedTask(root_);
+        }
+
+        std::suspend_never final_suspend() const noexcept { return {}; }
+
+        void return_void() const noexcept {}
+
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+
+    DetachedTask(DetachedTask&& other) noexcept : handle_(std::exchange(other.handle_, nullptr))
+    {
+    }
+
+    DetachedTask(const DetachedTask&) = delete;
+    DetachedTask& operator=(const DetachedTask&) = delete;
+    DetachedTask& operator=(DetachedTask&&) = delete;
+
+    ~DetachedTask()
+    {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    std::coroutine_handle<> Release() noexcept { return std::exchange(handle_, nullptr); }
+
+private:
+
+    explicit DetachedTask(const std::coroutine_handle<> handle) noexcept : handle_(handle)
+    {
+    }
+
+    std::coroutine_handle<> handle_;
+};
+
+
+// CoroutineResumer
+//
+// A move-only callable that resumes a suspended coroutine (a timer callback, or an Asio handler).
+// - Resumes the coroutine when invoked (any arguments, e.g., the timer id, are ignored).
+// - Destroyed without having been invoked (its timer was dropped, or the handler was discarded), it destroys the root of the
+//   coroutine's await chain, if it has one (see TaskPromiseBase), so an abandoned chain does not leak.
+
+class CoroutineResumer final
+{
+public:
+
+    CoroutineResumer(const std::coroutine_handle<> coroutine, const std::coroutine_handle<> root) noexcept :
+        coroutine_(coroutine), root_(root)
+    {
+    }
+
+    CoroutineResumer(CoroutineResumer&& other) noexcept :
+        coroutine_(std::exchange(other.coroutine_, nullptr)), root_(std::exchange(other.root_, nullptr))
+    {
+    }
+
+    CoroutineResumer(const CoroutineResumer&) = delete;
+    CoroutineResumer& operator=(const CoroutineResumer&) = delete;
+    CoroutineResumer& operator=(CoroutineResumer&&) = delete;
+
+    ~CoroutineResumer()
+    {
+        if (coroutine_ && root_) {
+            root_.destroy();
+        }
+    }
+
+    template <typename... Args>
+    void operator()(Args&&...)
+    {
+        root_ = nullptr;
+        std::exchange(coroutine_, nullptr).resume();
+    }
+
+private:
+
+    std::coroutine_handle<> coroutine_;
+    std::coroutine_handle<> root_;
+};
+
+#endif
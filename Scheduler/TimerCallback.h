@@ -0,0 +1,186 @@
+#ifndef AMITG_FC_TIMER_CALLBACK
+#define AMITG_FC_TIMER_CALLBACK
+
+/*
+    TimerCallback.h
+    Copyright (c) 2024, Amit Gefen
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+
+// TimerCallback
+//
+// Type-erased `void()` callable with small-buffer storage, used for the callback bound into each timer node.
+// - Callables of up to kInlineSize bytes (the user callback plus its bound arguments) are stored inline, so binding them
+//   allocates nothing. Larger ones fall back to a single heap allocation.
+// - Unlike std::function, the inline capacity is large enough for typical captures (a functor, a pointer and a few values).
+// - Move-only callables are accepted (like std::move_only_function). Copying a TimerCallback that holds one throws
+//   std::logic_error; IsCopyable() tells in advance.
+
+class TimerCallback final
+{
+public:
+
+    static constexpr std::size_t kInlineSize = 64;
+
+    TimerCallback() noexcept = default;
+
+    template <typename Function, typename = std::enable_if_t<!std::is_same_v<std::decay_t<Function>, TimerCallback>>>
+    TimerCallback(Function&& function)
+    {
+        Emplace<std::decay_t<Function>>(std::forward<Function>(function));
+    }
+
+    TimerCallback(TimerCallback&& other) noexcept : ops_(other.ops_)
+    {
+        if (ops_ != nullptr) {
+            ops_->move_(other.storage_, storage_);
+            other.ops_ = nullptr;
+        }
+    }
+
+    TimerCallback(const TimerCallback& other) : ops_(nullptr)
+    {
+        if (other.ops_ != nullptr) {
+            if (other.ops_->copy_ == nullptr) {
+                throw std::logic_error("TimerCallback: the callable is move-only");
+            }
+            other.ops_->copy_(other.storage_, storage_);
+            ops_ = other.ops_;
+        }
+    }
+
+    TimerCallback& operator=(TimerCallback&& other) noexcept
+    {
+        if (this != &other) {
+            Reset();
+            if (other.ops_ != nullptr) {
+                other.ops_->move_(other.storage_, storage_);
+                ops_ = other.ops_;
+                other.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    TimerCallback& operator=(const TimerCallback& other)
+    {
+        if (this != &other) {
+            TimerCallback copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    ~TimerCallback() { Reset(); }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    // IsCopyable(): Whether the held callable (if any) can be copied.
+    bool IsCopyable() const noexcept { return ops_ == nullptr || ops_->copy_ != nullptr; }
+
+    void operator()() { ops_->invoke_(storage_); }
+
+    void Reset() noexcept
+    {
+        if (ops_ != nullptr) {
+            ops_->destroy_(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    // Emplace<Stored>(stored_args...)
+    //
+    // Replaces the held callable with a `Stored` constructed in place from `stored_args` (not moved in afterwards, unlike
+    // assigning a TimerCallback made from it). If the constructor throws, the TimerCallback is left empty.
+    template <typename Stored, typename... StoredArgs>
+    void Emplace(StoredArgs&&... stored_args)
+    {
+        Reset();
+        if constexpr (IsInline<Stored>()) {
+            ::new (static_cast<void*>(storage_)) Stored(std::forward<StoredArgs>(stored_args)...);
+            ops_ = &kInlineOps<Stored>;
+        } else {
+            *reinterpret_cast<Stored**>(storage_) = new Stored(std::forward<StoredArgs>(stored_args)...);
+            ops_ = &kHeapOps<Stored>;
+        }
+    }
+
+private:
+
+    struct Ops
+    {
+        void (*invoke_)(void* storage);
+        void (*move_)(void* from, void* to) noexcept;
+        void (*copy_)(const void* from, void* to); // (nullptr for move-only callables)
+        void (*destroy_)(void* storage) noexcept;
+    };
+
+    template <typename Stored>
+    static constexpr bool IsInline() noexcept
+    {
+        return sizeof(Stored) <= kInlineSize && alignof(Stored) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<Stored>;
+    }
+
+    using CopyFunction = void (*)(const void* from, void* to);
+
+    // The copy operation of a stored callable, or nullptr if it is move-only.
+    template <typename Stored, bool Heap>
+    static constexpr CopyFunction CopyOp() noexcept
+    {
+        if constexpr (!std::is_copy_constructible_v<Stored>) {
+            return nullptr;
+        } else if constexpr (Heap) {
+            return [](const void* from, void* to) { *static_cast<Stored**>(to) = new Stored(**static_cast<Stored* const*>(from)); };
+        } else {
+            return [](const void* from, void* to) { ::new (to) Stored(*static_cast<const Stored*>(from)); };
+        }
+    }
+
+    template <typename Stored>
+    static constexpr Ops kInlineOps{
+        [](void* storage) { (*static_cast<Stored*>(storage))(); },
+        [](void* from, void* to) noexcept {
+            ::new (to) Stored(std::move(*static_cast<Stored*>(from)));
+            static_cast<Stored*>(from)->~Stored();
+        },
+        CopyOp<Stored, false>(),
+        [](void* storage) noexcept { static_cast<Stored*>(storage)->~Stored(); }
+    };
+
+    template <typename Stored>
+    static constexpr Ops kHeapOps{
+        [](void* storage) { (**static_cast<Stored**>(storage))(); },
+        [](void* from, void* to) noexcept { *static_cast<Stored**>(to) = *static_cast<Stored**>(from); },
+        CopyOp<Stored, true>(),
+        [](void* storage) noexcept { delete *static_cast<Stored**>(storage); }
+    };
+
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize]{};
+    const Ops* ops_{ nullptr };
+};
+
+#endif
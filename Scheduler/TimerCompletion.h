@@ -0,0 +1,253 @@
+#ifndef AMITG_FC_TIMER_COMPLETION
+#define AMITG_FC_TIMER_COMPLETION
+
+/*
+    TimerCompletion.h
+    Copyright (c) 2024, Amit Gefen
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+
+// TimerStatus: The state of a timer tracked by a TimerCompletion.
+// - Pending:   The timer has not fired yet (or its callback is still running).
+// - Fired:     The callback ran to completion (its result, if any, is available).
+// - Failed:    The callback threw (the exception is rethrown by TimerCompletion::Get(), not into the Scheduler's thread).
+// - Cancelled: The timer never fired: it was cancelled, replaced by a timer with the same id, dropped by a shutdown, or
+//              could not be scheduled.
+enum class TimerStatus : uint32_t
+{
+    Pending,
+    Fired,
+    Failed,
+    Cancelled
+};
+
+
+// TimerCompletionState<Result>
+//
+// The shared state between a timer's callback and its TimerCompletion handle.
+// - A single allocation with an intrusive reference count (one reference for each side); no mutex, no condition variable.
+// - The status is published with a release store once the result is in place, and waited on with std::atomic::wait().
+
+template <typename Result>
+class TimerCompletionState final
+{
+public:
+
+    using Value = std::conditional_t<std::is_void_v<Result>, std::monostate, Result>;
+
+    TimerStatus Status() const noexcept { return status_.load(std::memory_order_acquire); }
+
+    // Wait(): Blocks until the status is no longer Pending, and returns it.
+    TimerStatus Wait() const noexcept
+    {
+        TimerStatus status = Status();
+        while (status == TimerStatus::Pending) {
+            status_.wait(status, std::memory_order_acquire);
+            status = Status();
+        }
+        return status;
+    }
+
+    // Complete(status, value...) / Fail(exception): Called once, by the callback side.
+    template <typename... Values>
+    void Complete(const TimerStatus status, Values&&... value)
+    {
+        if constexpr (sizeof...(Values) > 0) {
+            value_.emplace(std::forward<Values>(value)...);
+        }
+        Publish(status);
+    }
+
+    void Fail(std::exception_ptr exception) noexcept
+    {
+        exception_ = std::move(exception);
+        Publish(TimerStatus::Failed);
+    }
+
+    // TakeValue() / Exception(): The outcome (after Wait()).
+    std::optional<Value> TakeValue() noexcept(std::is_nothrow_move_constructible_v<Value>) { return std::move(value_); }
+
+    const std::exception_ptr& Exception() const noexcept { return exception_; }
+
+    void Release() noexcept
+    {
+        if (references_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+private:
+
+    void Publish(const TimerStatus status) noexcept
+    {
+        status_.store(status, std::memory_order_release);
+        status_.notify_all();
+    }
+
+    std::atomic<TimerStatus> status_{ TimerStatus::Pending };
+    std::atomic<uint32_t> references_{ 2 };
+    std::optional<Value> value_{};
+    std::exception_ptr exception_{};
+};
+
+
+// TimerCompletion<Result>
+//
+// A small, move-only handle to the outcome of a one-shot timer (see Scheduler::ScheduleTimerCompletion()).
+// - Status() / Done() poll without blocking; Wait() blocks until the timer fired, failed or was cancelled.
+// - Get() waits and returns the callback's result: std::optional<Result> (empty if the timer was cancelled), or a bool
+//   (whether it fired) for void callbacks. It rethrows the exception the callback threw, and may be called once.
+// - May outlive the Scheduler. Waiting from a callback that runs on the thread that would fire the timer deadlocks.
+// - An empty handle (moved from, or returned for a timer whose state could not be allocated) reports TimerStatus::Cancelled.
+
+template <typename Result>
+class TimerCompletion final
+{
+public:
+
+    using State = TimerCompletionState<Result>;
+
+    explicit TimerCompletion(State* state) noexcept : state_(state)
+    {
+    }
+
+    TimerCompletion(TimerCompletion&& other) noexcept : state_(std::exchange(other.state_, nullptr))
+    {
+    }
+
+    TimerCompletion(const TimerCompletion&) = delete;
+    TimerCompletion& operator=(const TimerCompletion&) = delete;
+
+    TimerCompletion& operator=(TimerCompletion&& other) noexcept
+    {
+        if (this != &other) {
+            Reset();
+            state_ = std::exchange(other.state_, nullptr);
+        }
+        return *this;
+    }
+
+    ~TimerCompletion()
+    {
+        Reset();
+    }
+
+    TimerStatus Status() const noexcept { return state_ != nullptr ? state_->Status() : TimerStatus::Cancelled; }
+
+    bool Done() const noexcept { return Status() != TimerStatus::Pending; }
+
+    TimerStatus Wait() const noexcept { return state_ != nullptr ? state_->Wait() : TimerStatus::Cancelled; }
+
+    auto Get()
+    {
+        const TimerStatus status = Wait();
+        if (status == TimerStatus::Failed) {
+            std::rethrow_exception(state_->Exception());
+        }
+
+        if constexpr (std::is_void_v<Result>) {
+            return status == TimerStatus::Fired;
+        } else {
+            return state_ != nullptr ? state_->TakeValue() : std::optional<Result>{};
+        }
+    }
+
+private:
+
+    void Reset() noexcept
+    {
+        if (state_ != nullptr) {
+            std::exchange(state_, nullptr)->Release();
+        }
+    }
+
+    State* state_;
+};
+
+
+// TimerCompletionCallback<Result, Callback>
+//
+// Wraps a one-shot timer's callback so that it completes a TimerCompletionState.
+// - Invoked: runs the callback and publishes its result (Fired), or its exception (Failed). Like std::packaged_task, the
+//   exception is delivered through the handle only; it does not propagate into the Scheduler's thread.
+// - Destroyed without having been invoked (the timer never fired): publishes Cancelled.
+// Move-only; the moved-from wrapper no longer refers to the state.
+
+template <typename Result, typename Callback>
+class TimerCompletionCallback final
+{
+public:
+
+    template <typename Function>
+    TimerCompletionCallback(TimerCompletionState<Result>* state, Function&& callback) :
+        state_(state), callback_(std::forward<Function>(callback))
+    {
+    }
+
+    TimerCompletionCallback(TimerCompletionCallback&& other) noexcept(std::is_nothrow_move_constructible_v<Callback>) :
+        state_(std::exchange(other.state_, nullptr)), callback_(std::move(other.callback_))
+    {
+    }
+
+    TimerCompletionCallback(const TimerCompletionCallback&) = delete;
+    TimerCompletionCallback& operator=(const TimerCompletionCallback&) = delete;
+    TimerCompletionCallback& operator=(TimerCompletionCallback&&) = delete;
+
+    ~TimerCompletionCallback()
+    {
+        if (state_ != nullptr) {
+            state_->Complete(TimerStatus::Cancelled);
+            state_->Release();
+        }
+    }
+
+    template <typename... Args>
+    void operator()(Args&&... args)
+    {
+        TimerCompletionState<Result>* state = std::exchange(state_, nullptr);
+        try {
+            if constexpr (std::is_void_v<Result>) {
+                callback_(std::forward<Args>(args)...);
+                state->Complete(TimerStatus::Fired);
+            } else {
+                state->Complete(TimerStatus::Fired, callback_(std::forward<Args>(args)...));
+            }
+        } catch (...) {
+            state->Fail(std::current_exception());
+        }
+        state->Release();
+    }
+
+private:
+
+    TimerCompletionState<Result>* state_;
+    Callback callback_;
+};
+
+#endif
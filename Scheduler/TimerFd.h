@@ -0,0 +1,129 @@
+#ifndef AMITG_FC_TIMER_FD
+#define AMITG_FC_TIMER_FD
+
+/*
+    TimerFd.h
+    Copyright (c) 2024, Amit Gefen
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#if !defined(__linux__)
+#error "TimerFd.h (SCHEDULER_USE_TIMERFD) requires Linux timerfd"
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <utility>
+#include <errno.h>
+#include <sys/timerfd.h>
+#include <boost/asio.hpp>
+
+
+// TimerFd
+//
+// A steady_clock timer on a Linux timerfd (CLOCK_MONOTONIC, TFD_TIMER_ABSTIME), waited on through the io_service's reactor.
+// - Drop-in for the subset of boost::asio::steady_timer the TimingWheel engine uses (expires_at, async_wait, cancel), so
+//   Scheduler.h selects one or the other at compile time (SCHEDULER_USE_TIMERFD).
+// - The descriptor is registered with Asio's epoll reactor directly: an expiry skips Asio's timer queue (its heap, its
+//   lock, and the reactor's re-arming of its own timerfd).
+// - Like steady_timer, not thread-safe: one strand (or thread) at a time.
+// - Relies on libstdc++ / libc++ steady_clock being CLOCK_MONOTONIC.
+
+class TimerFd final
+{
+public:
+
+    using clock_type = std::chrono::steady_clock;
+    using time_point = clock_type::time_point;
+
+    // Throws boost::system::system_error if the timerfd cannot be created.
+    explicit TimerFd(boost::asio::io_service& io_service) : descriptor_(io_service, CreateTimerFd())
+    {
+    }
+
+    TimerFd(const TimerFd&) = delete;
+    TimerFd& operator=(const TimerFd&) = delete;
+
+    // expires_at(expiry)
+    //
+    // Sets the expiry of the next async_wait(); a pending wait completes with operation_aborted (as with steady_timer).
+    void expires_at(const time_point expiry)
+    {
+        descriptor_.cancel();
+        expiry_ = expiry;
+    }
+
+    // async_wait(handler)
+    //
+    // Completes `handler(error_code)` once the expiry is reached (operation_aborted if cancelled first).
+    // - `handler` is handed to the reactor as is, so its associated executor and allocator apply.
+    // - The wait is queued before the timerfd is armed: the reactor is edge-triggered, and an expiry that happened before
+    //   the wait was queued would be missed. (The expiration count is never read: re-arming the timerfd resets it.)
+    // - A readiness event left over from an expiry that was re-armed can complete a wait early, like a spurious wakeup.
+    //
+    // Throws:
+    //   - boost::system::system_error if the timerfd cannot be armed (the wait is cancelled).
+    template <typename Handler>
+    void async_wait(Handler&& handler)
+    {
+        descriptor_.async_wait(boost::asio::posix::descriptor_base::wait_read, std::forward<Handler>(handler));
+
+        const int64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(expiry_.time_since_epoch()).count();
+        const int64_t armed = nanoseconds > 0 ? nanoseconds : 1; // (An all-zero it_value would disarm the timerfd)
+
+        itimerspec spec{};
+        spec.it_value.tv_sec = static_cast<time_t>(armed / 1000000000);
+        spec.it_value.tv_nsec = static_cast<long>(armed % 1000000000);
+        if (::timerfd_settime(descriptor_.native_handle(), TFD_TIMER_ABSTIME, &spec, nullptr) != 0) {
+            const int error = errno;
+            descriptor_.cancel();
+            throw boost::system::system_error(error, boost::system::system_category(), "timerfd_settime");
+        }
+    }
+
+    // cancel()
+    //
+    // Disarms the timerfd; a pending wait completes with operation_aborted.
+    void cancel()
+    {
+        const itimerspec disarmed{};
+        ::timerfd_settime(descriptor_.native_handle(), 0, &disarmed, nullptr);
+        descriptor_.cancel();
+    }
+
+private:
+
+    static int CreateTimerFd()
+    {
+        const int fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (fd < 0) {
+            throw boost::system::system_error(errno, boost::system::system_category(), "timerfd_create");
+        }
+        return fd;
+    }
+
+    // - descriptor_: The timerfd (owned; closed by the descriptor).
+    // - expiry_:     The expiry of the next async_wait().
+    boost::asio::posix::stream_descriptor descriptor_;
+    time_point expiry_{};
+};
+
+#endif
@@ -0,0 +1,205 @@
+#ifndef AMITG_FC_TIMER_INDEX
+#define AMITG_FC_TIMER_INDEX
+
+/*
+    TimerIndex.h
+    Copyright (c) 2024, Amit Gefen
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+
+// MixTimerKey(key)
+//
+// SplitMix64 finalizer. Timer ids are often sequential (and affinity keys are aligned pointers), so the low bits need
+// mixing before they are used to pick a slot or a shard.
+inline uint64_t MixTimerKey(uint64_t key) noexcept
+{
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return key;
+}
+
+
+// TimerIndex<Value>
+//
+// Flat (open-addressing) hash index from timer_id to a node pointer.
+// - One contiguous array of {key, value} slots with linear probing; no per-entry allocation.
+// - Find(), Insert() and Erase() are O(1) on average. Erase() uses backward-shift deletion, so there are no tombstones
+//   and lookups stay short under heavy schedule/cancel churn.
+// - The table doubles when it is half full. A null value marks an empty slot (values are never null).
+// - Not thread-safe: the owner serializes all calls (the Scheduler only touches it on its engine strand).
+
+template <typename Value>
+class TimerIndex final
+{
+public:
+
+    TimerIndex() = default;
+
+    TimerIndex(const TimerIndex&) = delete;
+    TimerIndex& operator=(const TimerIndex&) = delete;
+
+    std::size_t Size() const noexcept { return size_; }
+
+    bool Empty() const noexcept { return size_ == 0; }
+
+    // Find(key)
+    //
+    // Returns the value stored for `key`, or nullptr.
+    Value* Find(const uint64_t key) const noexcept
+    {
+        if (capacity_ == 0) {
+            return nullptr;
+        }
+
+        for (std::size_t i = Hash(key) & mask_;; i = (i + 1) & mask_) {
+            const Slot& slot = slots_[i];
+            if (slot.value_ == nullptr) {
+                return nullptr;
+            }
+            if (slot.key_ == key) {
+                return slot.value_;
+            }
+        }
+    }
+
+    // Insert(key, value)
+    //
+    // Stores `value` for `key` and returns the value it replaced, or nullptr.
+    //
+    // Throws:
+    //   - std::bad_alloc if the table has to grow and the allocation fails (the index is left unchanged).
+    Value* Insert(const uint64_t key, Value* value)
+    {
+        if ((size_ + 1) * 2 > capacity_) {
+            Rehash(capacity_ == 0 ? kInitialCapacity : capacity_ * 2);
+        }
+
+        for (std::size_t i = Hash(key) & mask_;; i = (i + 1) & mask_) {
+            Slot& slot = slots_[i];
+            if (slot.value_ == nullptr) {
+                slot.key_ = key;
+                slot.value_ = value;
+                ++size_;
+                return nullptr;
+            }
+            if (slot.key_ == key) {
+                Value* previous = slot.value_;
+                slot.value_ = value;
+                return previous;
+            }
+        }
+    }
+
+    // Erase(key)
+    //
+    // Removes `key` and returns its value, or nullptr if it was not present.
+    Value* Erase(const uint64_t key) noexcept
+    {
+        if (capacity_ == 0) {
+            return nullptr;
+        }
+
+        std::size_t hole = Hash(key) & mask_;
+        for (;; hole = (hole + 1) & mask_) {
+            if (slots_[hole].value_ == nullptr) {
+                return nullptr;
+            }
+            if (slots_[hole].key_ == key) {
+                break;
+            }
+        }
+
+        Value* erased = slots_[hole].value_;
+        slots_[hole].value_ = nullptr;
+        --size_;
+
+        // Backward-shift: pull later entries of the probe run into the hole if their home slot allows it.
+        for (std::size_t i = (hole + 1) & mask_; slots_[i].value_ != nullptr; i = (i + 1) & mask_) {
+            const std::size_t home = Hash(slots_[i].key_) & mask_;
+            if (((i - home) & mask_) >= ((i - hole) & mask_)) {
+                slots_[hole] = slots_[i];
+                slots_[i].value_ = nullptr;
+                hole = i;
+            }
+        }
+
+        return erased;
+    }
+
+    // ForEach(function)
+    //
+    // Invokes `function(key, value)` for every entry (in no particular order). `function` must not modify the index.
+    template <typename Function>
+    void ForEach(Function&& function) const
+    {
+        for (std::size_t i = 0; i < capacity_; ++i) {
+            if (slots_[i].value_ != nullptr) {
+                function(slots_[i].key_, slots_[i].value_);
+            }
+        }
+    }
+
+private:
+
+    struct Slot
+    {
+        uint64_t key_{ 0 };
+        Value* value_{ nullptr };
+    };
+
+    static constexpr std::size_t kInitialCapacity = 64;
+
+    static std::size_t Hash(const uint64_t key) noexcept { return static_cast<std::size_t>(MixTimerKey(key)); }
+
+    void Rehash(const std::size_t capacity)
+    {
+        auto slots = std::make_unique<Slot[]>(capacity);
+        const std::size_t mask = capacity - 1;
+
+        for (std::size_t i = 0; i < capacity_; ++i) {
+            if (slots_[i].value_ != nullptr) {
+                std::size_t j = Hash(slots_[i].key_) & mask;
+                while (slots[j].value_ != nullptr) {
+                    j = (j + 1) & mask;
+                }
+                slots[j] = slots_[i];
+            }
+        }
+
+        slots_ = std::move(slots);
+        capacity_ = capacity;
+        mask_ = mask;
+    }
+
+    std::unique_ptr<Slot[]> slots_{};
+    std::size_t capacity_{ 0 };
+    std::size_t mask_{ 0 };
+    std::size_t size_{ 0 };
+};
+
+#endif
@@ -0,0 +1,329 @@
+#ifndef AMITG_FC_TIMER_POOL
+#define AMITG_FC_TIMER_POOL
+
+/*
+    TimerPool.h
+    Copyright (c) 2024, Amit Gefen
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+
+// FixedBlockPool
+//
+// Thread-safe pool of equally sized memory blocks, carved out of chunks that are allocated on demand and kept until the
+// pool is destroyed. Once the pool has grown to the peak number of blocks in use, Allocate() and Deallocate() never touch
+// the heap again.
+// - The first chunk holds kFirstChunkBlocks blocks, and every next one twice as many as the last, up to `blocks_per_chunk`:
+//   a pool that serves a handful of blocks (e.g., a Scheduler with a few timers) stays small, and a busy one still grows
+//   in a few large steps.
+// - The free blocks form a lock-free stack (Treiber): Allocate() pops a block with one CAS and Deallocate() pushes one with
+//   one CAS, so threads scheduling timers concurrently never queue up behind a lock. Only Grow() takes a mutex.
+// - The head word packs the top block's address with a counter that every pop increments, so a pop that raced with other
+//   threads popping and pushing the same block back (ABA) fails its CAS instead of corrupting the stack. On 64-bit targets
+//   the address must fit in 48 bits (user space on x86-64 and AArch64; Grow() checks every chunk), which leaves the
+//   counter 20 bits.
+
+class FixedBlockPool final
+{
+public:
+
+    FixedBlockPool(const std::size_t block_size, const std::size_t blocks_per_chunk) :
+        block_size_(RoundUp(std::max(block_size, sizeof(FreeBlock)))),
+        blocks_per_chunk_(std::max<std::size_t>(blocks_per_chunk, 1)),
+        next_chunk_blocks_(std::min(kFirstChunkBlocks, blocks_per_chunk_))
+    {
+    }
+
+    FixedBlockPool(const FixedBlockPool&) = delete;
+    FixedBlockPool& operator=(const FixedBlockPool&) = delete;
+
+    std::size_t BlockSize() const noexcept { return block_size_; }
+
+    // Allocate()
+    //
+    // Returns a block of BlockSize() bytes, aligned for std::max_align_t.
+    //
+    // Throws:
+    //   - std::bad_alloc if the pool has to grow and the allocation fails.
+    void* Allocate()
+    {
+        uint64_t head = head_.load(std::memory_order_acquire);
+        for (;;) {
+            FreeBlock* block = BlockOf(head);
+            if (block == nullptr) {
+                Grow();
+                head = head_.load(std::memory_order_acquire);
+                continue;
+            }
+
+            // (If another thread pops `block` first, `next` may be stale: the counter has moved on, and the CAS fails)
+            FreeBlock* next = std::atomic_ref(block->next_).load(std::memory_order_relaxed);
+            if (head_.compare_exchange_weak(head, Pack(next, CounterOf(head) + 1), std::memory_order_acquire, std::memory_order_acquire)) {
+                return block;
+            }
+        }
+    }
+
+    // Deallocate(block)
+    //
+    // Returns a block obtained from Allocate() to the pool.
+    void Deallocate(void* block) noexcept
+    {
+        auto* free_block = static_cast<FreeBlock*>(block);
+        Push(free_block, free_block);
+    }
+
+private:
+
+    // FreeBlock: A free block's link. Accessed through std::atomic_ref once the block is on the stack, as a pop may read it
+    // while another thread pops and reuses the block.
+    struct FreeBlock
+    {
+        FreeBlock* next_;
+    };
+
+    static constexpr std::size_t kFirstChunkBlocks = 16;
+
+    // Head word layout: the address divided by the block alignment in the low kAddressBits bits, the pop counter above.
+    static constexpr std::size_t kAlignment = alignof(std::max_align_t);
+    static constexpr unsigned kAlignmentBits = static_cast<unsigned>(std::countr_zero(kAlignment));
+    static constexpr unsigned kAddressBits = (sizeof(void*) == 8 ? 48 : 32) - kAlignmentBits;
+    static constexpr uint64_t kAddressMask = (uint64_t{ 1 } << kAddressBits) - 1;
+
+    static uint64_t Pack(const FreeBlock* block, const uint64_t counter) noexcept
+    {
+        return (static_cast<uint64_t>(reinterpret_cast<std::uintptr_t>(block)) >> kAlignmentBits) | (counter << kAddressBits);
+    }
+
+    static FreeBlock* BlockOf(const uint64_t head) noexcept
+    {
+        return reinterpret_cast<FreeBlock*>(static_cast<std::uintptr_t>((head & kAddressMask) << kAlignmentBits));
+    }
+
+    static uint64_t CounterOf(const uint64_t head) noexcept
+    {
+        return head >> kAddressBits;
+    }
+
+    static std::size_t RoundUp(const std::size_t size) noexcept
+    {
+        return (size + kAlignment - 1) / kAlignment * kAlignment;
+    }
+
+    // Push(first, last): Pushes the chain first -> ... -> last onto the free stack (a push needs no counter: only pops race).
+    void Push(FreeBlock* first, FreeBlock* last) noexcept
+    {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        do {
+            std::atomic_ref(last->next_).store(BlockOf(head), std::memory_order_relaxed);
+        } while (!head_.compare_exchange_weak(head, Pack(first, CounterOf(head)), std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // Grow(): Adds a chunk of blocks to the free stack, unless another thread did so while this one waited for the mutex.
+    void Grow()
+    {
+        const std::lock_guard lock(grow_mutex_);
+        if (BlockOf(head_.load(std::memory_order_acquire)) != nullptr) {
+            return;
+        }
+
+        const std::size_t blocks = next_chunk_blocks_;
+        chunks_.reserve(chunks_.size() + 1);
+        auto chunk = std::make_unique<std::max_align_t[]>(block_size_ * blocks / sizeof(std::max_align_t));
+        auto* memory = reinterpret_cast<unsigned char*>(chunk.get());
+        if constexpr (sizeof(void*) == 8) {
+            if ((reinterpret_cast<std::uintptr_t>(memory + block_size_ * blocks) >> 48) != 0) {
+                throw std::bad_alloc(); // (Above the addresses the head word can hold)
+            }
+        }
+        chunks_.push_back(std::move(chunk));
+        next_chunk_blocks_ = std::min(blocks * 2, blocks_per_chunk_);
+
+        FreeBlock* first = nullptr;
+        FreeBlock* last = nullptr;
+        for (std::size_t i = blocks; i-- > 0;) {
+            auto* block = ::new (memory + i * block_size_) FreeBlock{ first };
+            first = block;
+            last = last != nullptr ? last : block;
+        }
+        Push(first, last);
+    }
+
+    const std::size_t block_size_;
+    const std::size_t blocks_per_chunk_;
+    std::atomic<uint64_t> head_{ 0 };
+    std::size_t next_chunk_blocks_; // (Guarded by grow_mutex_)
+    std::mutex grow_mutex_{};
+    std::vector<std::unique_ptr<std::max_align_t[]>> chunks_{};
+};
+
+
+// HandlerMemoryPool
+//
+// Memory for Boost Asio handlers (the operations Asio allocates for post() and async_wait()), in power-of-two size
+// classes backed by FixedBlockPool. Requests larger than the biggest class fall back to the global heap.
+
+class HandlerMemoryPool final
+{
+public:
+
+    HandlerMemoryPool() :
+        classes_{ {
+            FixedBlockPool(kSmallestClass, kBlocksPerChunk),
+            FixedBlockPool(kSmallestClass << 1, kBlocksPerChunk),
+            FixedBlockPool(kSmallestClass << 2, kBlocksPerChunk),
+            FixedBlockPool(kSmallestClass << 3, kBlocksPerChunk),
+            FixedBlockPool(kSmallestClass << 4, kBlocksPerChunk) } }
+    {
+    }
+
+    HandlerMemoryPool(const HandlerMemoryPool&) = delete;
+    HandlerMemoryPool& operator=(const HandlerMemoryPool&) = delete;
+
+    void* Allocate(const std::size_t size)
+    {
+        if (FixedBlockPool* pool = ClassFor(size)) {
+            return pool->Allocate();
+        }
+        return ::operator new(size);
+    }
+
+    void Deallocate(void* memory, const std::size_t size) noexcept
+    {
+        if (FixedBlockPool* pool = ClassFor(size)) {
+            pool->Deallocate(memory);
+        } else {
+            ::operator delete(memory);
+        }
+    }
+
+private:
+
+    static constexpr std::size_t kSmallestClass = 64;
+    static constexpr std::size_t kBlocksPerChunk = 256;
+
+    FixedBlockPool* ClassFor(const std::size_t size) noexcept
+    {
+        for (auto& pool : classes_) {
+            if (size <= pool.BlockSize()) {
+                return &pool;
+            }
+        }
+        return nullptr;
+    }
+
+    std::array<FixedBlockPool, 5> classes_;
+};
+
+
+// HandlerAllocator<T>
+//
+// Standard allocator over a HandlerMemoryPool; Asio picks it up as the associated allocator of a PooledHandler.
+// Without a pool, allocates from the global heap.
+
+template <typename T>
+class HandlerAllocator final
+{
+public:
+
+    using value_type = T;
+
+    explicit HandlerAllocator(HandlerMemoryPool* pool) noexcept : pool_(pool)
+    {
+    }
+
+    template <typename U>
+    HandlerAllocator(const HandlerAllocator<U>& other) noexcept : pool_(other.pool_)
+    {
+    }
+
+    T* allocate(const std::size_t n)
+    {
+        return static_cast<T*>(pool_ ? pool_->Allocate(n * sizeof(T)) : ::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, const std::size_t n) noexcept
+    {
+        if (pool_) {
+            pool_->Deallocate(p, n * sizeof(T));
+        } else {
+            ::operator delete(p);
+        }
+    }
+
+    template <typename U>
+    bool operator==(const HandlerAllocator<U>& other) const noexcept { return pool_ == other.pool_; }
+
+    template <typename U>
+    bool operator!=(const HandlerAllocator<U>& other) const noexcept { return pool_ != other.pool_; }
+
+private:
+
+    template <typename U>
+    friend class HandlerAllocator;
+
+    HandlerMemoryPool* pool_;
+};
+
+
+// PooledHandler<Handler>
+//
+// Wraps a completion handler (typically a lambda) so that Asio allocates its operation from a HandlerMemoryPool
+// instead of the global heap (Asio looks up the nested allocator_type / get_allocator()).
+// - `pool` may be null, for handlers that can outlive any pool (they then allocate from the global heap).
+
+template <typename Handler>
+class PooledHandler final
+{
+public:
+
+    using allocator_type = HandlerAllocator<void>;
+
+    PooledHandler(HandlerMemoryPool* pool, Handler handler) : pool_(pool), handler_(std::move(handler))
+    {
+    }
+
+    allocator_type get_allocator() const noexcept { return allocator_type(pool_); }
+
+    template <typename... Args>
+    void operator()(Args&&... args)
+    {
+        handler_(std::forward<Args>(args)...);
+    }
+
+private:
+
+    HandlerMemoryPool* pool_;
+    Handler handler_;
+};
+
+#endif
@@ -0,0 +1,731 @@
+#ifndef AMITG_FC_TIMER_STORE
+#define AMITG_FC_TIMER_STORE
+
+/*
+    TimerStore.h
+    Copyright (c) 2024, Amit Gefen
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+// OverduePolicy: What a Scheduler does on start with the persistent timers that came due while it was not running.
+// - Fire: They fire right away (with TimerEngine::AsioTimer, in deadline order).
+// - Drop: They are erased from the store without firing.
+enum class OverduePolicy : uint8_t
+{
+    Fire,
+    Drop
+};
+
+// PersistentTimerHandler: Runs the persistent timers that fire: `handler(timer_id, payload)`, with the payload passed to
+// Scheduler::SchedulePersistent() (the bytes are valid for the duration of the call).
+using PersistentTimerHandler = std::function<void(uint64_t timer_id, std::span<const std::byte> payload)>;
+
+
+// TimerStoreOptions: Configuration of a Scheduler's persistent timer store (see Scheduler::SchedulePersistent()).
+struct TimerStoreOptions
+{
+    // path: The store's log file, created if missing (empty: no store; persistent timers are not available).
+    std::string path{};
+
+    // handler: Runs every persistent timer that fires, reloaded ones included (required with a path).
+    PersistentTimerHandler handler{};
+
+    // overdue: What to do with the reloaded timers whose deadline passed while the Scheduler was not running.
+    OverduePolicy overdue{ OverduePolicy::Fire };
+
+    // compaction_min_bytes, compaction_ratio: The log is compacted (rewritten with the pending timers' records only) once it
+    // is larger than compaction_min_bytes and than compaction_ratio times the size of those records.
+    std::size_t compaction_min_bytes{ std::size_t{ 1 } << 20 };
+    double compaction_ratio{ 2.0 };
+};
+
+
+// TimerStoreStats: A snapshot of a TimerStore (see Scheduler::StoreStats()).
+// - pending:     Timers recorded in the store and not erased yet.
+// - log_bytes:   The log's size up to its last record (the file itself grows ahead of it).
+// - live_bytes:  The pending timers' share of log_bytes.
+// - compactions: Times the log was compacted.
+// - compaction_failures: Compactions that failed (e.g., the disk is full); the log stays as it was.
+struct TimerStoreStats
+{
+    uint64_t pending{ 0 };
+    uint64_t log_bytes{ 0 };
+    uint64_t live_bytes{ 0 };
+    uint64_t compactions{ 0 };
+    uint64_t compaction_failures{ 0 };
+};
+
+
+// MappedFile
+//
+// A file mapped into memory in full, read-write and shared (the writes reach the file through the page cache).
+// - Open() maps the file at its current size; Resize() grows or shrinks the file and maps it again (the data moves).
+// - Throws std::system_error on failure.
+
+class MappedFile final
+{
+public:
+
+    MappedFile() noexcept = default;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        Close();
+    }
+
+    // Open(path, truncate): Opens or creates the file, emptied if `truncate`, and maps it.
+    void Open(const std::string& path, const bool truncate)
+    {
+        Close();
+#if defined(_WIN32)
+        file_ = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+            truncate ? CREATE_ALWAYS : OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) {
+            throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "CreateFile " + path);
+        }
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(file_, &size)) {
+            const DWORD error = GetLastError();
+            Close();
+            throw std::system_error(static_cast<int>(error), std::system_category(), "GetFileSizeEx " + path);
+        }
+        Map(static_cast<std::size_t>(size.QuadPart));
+#else
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : 0), 0644);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "open " + path);
+        }
+        struct stat status{};
+        if (::fstat(fd_, &status) != 0) {
+            const int error = errno;
+            Close();
+            throw std::system_error(error, std::generic_category(), "fstat " + path);
+        }
+        Map(static_cast<std::size_t>(status.st_size));
+#endif
+    }
+
+    // Resize(size): Sets the file's size (new bytes are zero) and maps it again.
+    void Resize(const std::size_t size)
+    {
+        Unmap();
+#if defined(_WIN32)
+        LARGE_INTEGER position{};
+        position.QuadPart = static_cast<LONGLONG>(size);
+        if (!SetFilePointerEx(file_, position, nullptr, FILE_BEGIN) || !SetEndOfFile(file_)) {
+            throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "SetEndOfFile");
+        }
+#else
+        if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+            throw std::system_error(errno, std::generic_category(), "ftruncate");
+        }
+#endif
+        Map(size);
+    }
+
+    // Flush(): Writes the mapped pages, and the file's metadata, to the disk.
+    void Flush()
+    {
+        if (data_ == nullptr) {
+            return;
+        }
+#if defined(_WIN32)
+        if (!FlushViewOfFile(data_, 0) || !FlushFileBuffers(file_)) {
+            throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "FlushViewOfFile");
+        }
+#else
+        if (::msync(data_, size_, MS_SYNC) != 0) {
+            throw std::system_error(errno, std::generic_category(), "msync");
+        }
+#endif
+    }
+
+    void Close() noexcept
+    {
+        Unmap();
+#if defined(_WIN32)
+        if (file_ != INVALID_HANDLE_VALUE) {
+            CloseHandle(std::exchange(file_, INVALID_HANDLE_VALUE));
+        }
+#else
+        if (fd_ >= 0) {
+            ::close(std::exchange(fd_, -1));
+        }
+#endif
+    }
+
+    // Swap(other): Exchanges the files (and their mappings).
+    void Swap(MappedFile& other) noexcept
+    {
+#if defined(_WIN32)
+        std::swap(file_, other.file_);
+        std::swap(mapping_, other.mapping_);
+#else
+        std::swap(fd_, other.fd_);
+#endif
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+    }
+
+    std::byte* Data() const noexcept { return data_; }
+
+    std::size_t Size() const noexcept { return size_; }
+
+private:
+
+    void Map(const std::size_t size)
+    {
+        if (size == 0) {
+            return;
+        }
+#if defined(_WIN32)
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READWRITE, static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+            static_cast<DWORD>(size), nullptr);
+        void* data = mapping_ != nullptr ? MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, size) : nullptr;
+        if (data == nullptr) {
+            const DWORD error = GetLastError();
+            Unmap();
+            throw std::system_error(static_cast<int>(error), std::system_category(), "MapViewOfFile");
+        }
+#else
+        void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (data == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "mmap");
+        }
+#endif
+        data_ = static_cast<std::byte*>(data);
+        size_ = size;
+    }
+
+    void Unmap() noexcept
+    {
+#if defined(_WIN32)
+        if (data_ != nullptr) {
+            UnmapViewOfFile(data_);
+        }
+        if (mapping_ != nullptr) {
+            CloseHandle(std::exchange(mapping_, nullptr));
+        }
+#else
+        if (data_ != nullptr) {
+            ::munmap(data_, size_);
+        }
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+#if defined(_WIN32)
+    HANDLE file_{ INVALID_HANDLE_VALUE };
+    HANDLE mapping_{ nullptr };
+#else
+    int fd_{ -1 };
+#endif
+    std::byte* data_{ nullptr };
+    std::size_t size_{ 0 };
+};
+
+
+// TimerStore
+//
+// The persistent timer store: an append-only log of records, in a memory-mapped file (see MappedFile).
+// - Put records a timer (id, sequence, absolute deadline, payload), Erase retires it. A record is written in place in the
+//   mapping (a copy, no system call) with its size last, so a record torn by a crash fails its checksum, and ends the log.
+//   Writes reach the file through the page cache: they survive a crash of the process; Flush() makes them survive a crash
+//   of the machine.
+// - `sequence` tells two timers with the same id apart (a timer that was replaced and the one that replaced it), so an
+//   Erase for a timer never retires its replacement. Updating a timer's deadline keeps its sequence.
+// - An in-memory index maps each pending timer's sequence to its record. A timer's record stays until the timer itself is
+//   erased, even if a newer one with the same id was put meanwhile: two calls that schedule the same id race to the
+//   Scheduler's engine, which may apply them in either order, and erases the record of the one it replaced. On Load(),
+//   only the newest of any records left with the same id (by a crash between the two) is kept.
+// - Once the log has grown past TimerStoreOptions::compaction_min_bytes and compaction_ratio times the pending records,
+//   it is compacted, on a thread of the store's own: the pending records are copied into a new file, which then replaces
+//   the log (a rename, so a crash leaves either file whole). See Compact().
+// - Deadlines are system_clock time: steady_clock does not carry over a restart (or a reboot).
+// - Thread-safe: every operation holds a mutex, for a short copy (and now and then a remap as the log grows), but Flush(),
+//   which holds it while the log is written to the disk. The compactor copies and flushes without it.
+
+class TimerStore final
+{
+public:
+
+    // Entry: A pending timer, as reloaded by ForEach(). `payload` refers into the mapping, valid during the visit only.
+    struct Entry
+    {
+        uint64_t timer_id{ 0 };
+        uint64_t sequence{ 0 };
+        std::chrono::system_clock::time_point deadline{};
+        std::span<const std::byte> payload{};
+    };
+
+    // Constructor (options)
+    //
+    // Opens the log (creating it if missing), and indexes its pending timers.
+    //
+    // Throws:
+    //   - std::system_error if the file cannot be opened or mapped, or the compactor thread cannot be started.
+    //   - std::runtime_error if the file is not a timer store.
+    explicit TimerStore(const TimerStoreOptions& options) :
+        path_(options.path),
+        compaction_min_bytes_(options.compaction_min_bytes),
+        compaction_ratio_(std::max(options.compaction_ratio, 1.0))
+    {
+        file_.Open(path_, false);
+        if (file_.Size() == 0) {
+            file_.Resize(kInitialSize);
+            std::memcpy(file_.Data(), &kMagic, sizeof(kMagic));
+        } else if (file_.Size() < kHeaderSize || std::memcmp(file_.Data(), &kMagic, sizeof(kMagic)) != 0) {
+            throw std::runtime_error("not a timer store: " + path_);
+        }
+        Load();
+        compactor_ = std::jthread([this](const std::stop_token stop) { RunCompactor(stop); });
+    }
+
+    TimerStore(const TimerStore&) = delete;
+    TimerStore& operator=(const TimerStore&) = delete;
+
+    // Destructor: Stops the compactor (abandoning a compaction in progress), and flushes the log to the disk (errors are
+    // ignored; the page cache still has the records).
+    ~TimerStore()
+    {
+        compactor_.request_stop();
+        compactor_.join();
+        try {
+            file_.Flush();
+        } catch (const std::exception&) {
+        }
+    }
+
+    // Put(timer_id, deadline, payload): Records a new timer, and returns its sequence. Throws std::system_error if the log
+    // cannot grow.
+    uint64_t Put(const uint64_t timer_id, const std::chrono::system_clock::time_point deadline, const std::span<const std::byte> payload)
+    {
+        std::lock_guard lock(mutex_);
+        const uint64_t sequence = ++last_sequence_;
+        Reserve(RecordSize(payload.size()));
+        Index(timer_id, sequence, Append(RecordKind::Put, timer_id, sequence, ToTicks(deadline), payload));
+        MaybeCompact();
+        return sequence;
+    }
+
+    // Update(timer_id, sequence, deadline): Records a new deadline for a pending timer (no effect if it is not pending).
+    void Update(const uint64_t timer_id, const uint64_t sequence, const std::chrono::system_clock::time_point deadline)
+    {
+        std::lock_guard lock(mutex_);
+        const auto found = Find(timer_id, sequence);
+        if (found == index_.end()) {
+            return;
+        }
+
+        const std::size_t payload_size = ReadHeader(found->second.offset_).payload_size_;
+        Reserve(RecordSize(payload_size)); // (May move the mapping: the payload is looked up after)
+        const std::span<const std::byte> payload(file_.Data() + found->second.offset_ + kRecordHeaderSize, payload_size);
+        Index(timer_id, sequence, Append(RecordKind::Put, timer_id, sequence, ToTicks(deadline), payload));
+        MaybeCompact();
+    }
+
+    // Erase(timer_id, sequence): Retires a timer (no effect if it is not pending). Another timer with the same id keeps its
+    // record.
+    void Erase(const uint64_t timer_id, const uint64_t sequence)
+    {
+        std::lock_guard lock(mutex_);
+        const auto found = Find(timer_id, sequence);
+        if (found == index_.end()) {
+            return;
+        }
+
+        Reserve(RecordSize(0));
+        Append(RecordKind::Erase, timer_id, sequence, 0, {});
+        live_bytes_ -= found->second.size_;
+        index_.erase(found);
+        MaybeCompact();
+    }
+
+    // Read(timer_id, sequence, payload): Copies a pending timer's payload into `payload`; false if it is not pending.
+    bool Read(const uint64_t timer_id, const uint64_t sequence, std::vector<std::byte>& payload) const
+    {
+        std::lock_guard lock(mutex_);
+        const auto found = Find(timer_id, sequence);
+        if (found == index_.end()) {
+            return false;
+        }
+
+        const std::byte* record = file_.Data() + found->second.offset_;
+        payload.assign(record + kRecordHeaderSize, record + kRecordHeaderSize + ReadHeader(found->second.offset_).payload_size_);
+        return true;
+    }
+
+    // ForEach(visitor): Calls `visitor(entry)` for every pending timer, in no particular order (holding the store's mutex).
+    template <typename Visitor>
+    void ForEach(Visitor&& visitor) const
+    {
+        std::lock_guard lock(mutex_);
+        for (const auto& [sequence, slot] : index_) {
+            const RecordHeader header = ReadHeader(slot.offset_);
+            visitor(Entry{ slot.timer_id_, sequence, FromTicks(header.deadline_),
+                std::span<const std::byte>(file_.Data() + slot.offset_ + kRecordHeaderSize, header.payload_size_) });
+        }
+    }
+
+    // Flush(): Writes the log to the disk (see MappedFile::Flush()).
+    void Flush()
+    {
+        std::lock_guard lock(mutex_);
+        file_.Flush();
+    }
+
+    TimerStoreStats Stats() const
+    {
+        std::lock_guard lock(mutex_);
+        return TimerStoreStats{ index_.size(), end_, live_bytes_, compactions_, compaction_failures_ };
+    }
+
+private:
+
+    enum class RecordKind : uint32_t
+    {
+        Put = 1,
+        Erase = 2
+    };
+
+    // RecordHeader: The fixed part of a record, followed by the payload and padding to 8 bytes.
+    // - size_:     The whole record's size; written last (zero: the end of the log).
+    // - checksum_: FNV-1a of the record after these two fields.
+    // - deadline_: system_clock ticks (Put only).
+    struct RecordHeader
+    {
+        uint32_t size_{ 0 };
+        uint32_t checksum_{ 0 };
+        RecordKind kind_{ RecordKind::Put };
+        uint32_t payload_size_{ 0 };
+        uint64_t timer_id_{ 0 };
+        uint64_t sequence_{ 0 };
+        int64_t deadline_{ 0 };
+    };
+
+    // Slot: Where a pending timer's latest record is (indexed by the timer's sequence).
+    struct Slot
+    {
+        uint64_t timer_id_{ 0 };
+        std::size_t offset_{ 0 };
+        std::size_t size_{ 0 };
+    };
+
+    static constexpr uint64_t kMagic = 0x3130'5453'4754'494d; // "MITGST01" in file (little-endian)
+    static constexpr std::size_t kHeaderSize = 64;
+    static constexpr std::size_t kRecordHeaderSize = sizeof(RecordHeader);
+    static constexpr std::size_t kInitialSize = std::size_t{ 64 } << 10;
+
+    static std::size_t RecordSize(const std::size_t payload_size) noexcept
+    {
+        return (kRecordHeaderSize + payload_size + 7) & ~std::size_t{ 7 };
+    }
+
+    static int64_t ToTicks(const std::chrono::system_clock::time_point time) noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    }
+
+    static std::chrono::system_clock::time_point FromTicks(const int64_t ticks) noexcept
+    {
+        return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(ticks)));
+    }
+
+    static uint32_t Checksum(const std::byte* data, const std::size_t size) noexcept
+    {
+        uint32_t hash = 2166136261u;
+        for (std::size_t i = 0; i < size; ++i) {
+            hash = (hash ^ static_cast<uint32_t>(data[i])) * 16777619u;
+        }
+        return hash;
+    }
+
+    RecordHeader ReadHeader(const std::size_t offset) const noexcept
+    {
+        RecordHeader header{};
+        std::memcpy(&header, file_.Data() + offset, sizeof(header));
+        return header;
+    }
+
+    // Load(): Indexes the log, up to its first empty or torn record.
+    void Load()
+    {
+        std::size_t offset = kHeaderSize;
+        while (offset + kRecordHeaderSize <= file_.Size()) {
+            const RecordHeader header = ReadHeader(offset);
+            if (header.size_ < kRecordHeaderSize || header.size_ % 8 != 0 || header.size_ > file_.Size() - offset ||
+                RecordSize(header.payload_size_) != header.size_ ||
+                Checksum(file_.Data() + offset + 8, kRecordHeaderSize - 8 + header.payload_size_) != header.checksum_) {
+                break;
+            }
+
+            last_sequence_ = std::max(last_sequence_, header.sequence_);
+            if (header.kind_ == RecordKind::Put) {
+                Index(header.timer_id_, header.sequence_, offset);
+            } else if (const auto found = Find(header.timer_id_, header.sequence_); found != index_.end()) {
+                live_bytes_ -= found->second.size_;
+                index_.erase(found);
+            }
+            offset += header.size_;
+        }
+        end_ = offset;
+
+        // Timers with the same id whose replacement was put but that were not erased yet (see TimerStore) are dropped from
+        // the index; their records go with the next compaction.
+        std::unordered_map<uint64_t, uint64_t> newest{};
+        for (const auto& [sequence, slot] : index_) {
+            uint64_t& newest_sequence = newest[slot.timer_id_];
+            newest_sequence = std::max(newest_sequence, sequence);
+        }
+        std::erase_if(index_, [this, &newest](const auto& entry) {
+            if (newest[entry.second.timer_id_] == entry.first) {
+                return false;
+            }
+            live_bytes_ -= entry.second.size_;
+            return true;
+            });
+    }
+
+    // Find(timer_id, sequence): The index entry of a pending timer; index_.end() if it is not pending.
+    std::unordered_map<uint64_t, Slot>::iterator Find(const uint64_t timer_id, const uint64_t sequence) noexcept
+    {
+        const auto found = index_.find(sequence);
+        return found != index_.end() && found->second.timer_id_ == timer_id ? found : index_.end();
+    }
+
+    std::unordered_map<uint64_t, Slot>::const_iterator Find(const uint64_t timer_id, const uint64_t sequence) const noexcept
+    {
+        const auto found = index_.find(sequence);
+        return found != index_.end() && found->second.timer_id_ == timer_id ? found : index_.end();
+    }
+
+    // Index(timer_id, sequence, offset): Makes the record at `offset` the timer's latest.
+    void Index(const uint64_t timer_id, const uint64_t sequence, const std::size_t offset)
+    {
+        Slot& slot = index_[sequence];
+        live_bytes_ -= slot.size_;
+        slot = Slot{ timer_id, offset, ReadHeader(offset).size_ };
+        live_bytes_ += slot.size_;
+    }
+
+    // Reserve(size): Grows the file (doubling it) so a record of `size` bytes, and the end marker after it, fit.
+    void Reserve(const std::size_t size)
+    {
+        const std::size_t needed = end_ + size + sizeof(uint32_t);
+        if (needed > file_.Size()) {
+            file_.Resize(std::max(needed, file_.Size() * 2));
+        }
+    }
+
+    // Append(kind, timer_id, sequence, deadline, payload): Writes a record at the end of the log (after Reserve()), and
+    // returns its offset.
+    std::size_t Append(const RecordKind kind, const uint64_t timer_id, const uint64_t sequence, const int64_t deadline,
+        const std::span<const std::byte> payload) noexcept
+    {
+        const std::size_t offset = end_;
+        std::byte* record = file_.Data() + offset;
+
+        RecordHeader header{ 0, 0, kind, static_cast<uint32_t>(payload.size()), timer_id, sequence, deadline };
+        std::memcpy(record, &header, sizeof(header));
+        if (!payload.empty()) {
+            std::memmove(record + kRecordHeaderSize, payload.data(), payload.size());
+        }
+        const std::size_t size = RecordSize(payload.size());
+        std::memset(record + kRecordHeaderSize + payload.size(), 0, size - kRecordHeaderSize - payload.size());
+
+        // The end marker first, then the checksum, then the size that makes the record part of the log:
+        const uint32_t end_marker = 0;
+        std::memcpy(record + size, &end_marker, sizeof(end_marker));
+        header.checksum_ = Checksum(record + 8, kRecordHeaderSize - 8 + payload.size());
+        std::memcpy(record + 4, &header.checksum_, sizeof(header.checksum_));
+        header.size_ = static_cast<uint32_t>(size);
+        std::memcpy(record, &header.size_, sizeof(header.size_));
+
+        end_ += size;
+        return offset;
+    }
+
+    // MaybeCompact(): Wakes the compactor once the log is mostly retired records (see TimerStoreOptions; under mutex_).
+    void MaybeCompact() noexcept
+    {
+        if (compacting_ || end_ < std::max(compaction_min_bytes_, retry_compaction_at_) ||
+            static_cast<double>(end_) < compaction_ratio_ * static_cast<double>(kHeaderSize + live_bytes_)) {
+            return;
+        }
+
+        compacting_ = true;
+        compaction_requested_.notify_one();
+    }
+
+    // RunCompactor(stop): The compactor thread; compacts the log whenever MaybeCompact() asks, until the store is destroyed.
+    void RunCompactor(const std::stop_token stop)
+    {
+        std::unique_lock lock(mutex_);
+        while (compaction_requested_.wait(lock, stop, [this] { return compacting_; })) {
+            lock.unlock();
+            Compact(stop);
+            lock.lock();
+            compacting_ = false;
+        }
+    }
+
+    // Compact(stop)
+    //
+    // Rewrites the log with its pending records only, mostly without holding mutex_:
+    // 1. Under the mutex: notes the end of the log (`cut`) and where the pending records are.
+    // 2. Unlocked: maps the log a second time (the records before `cut` no longer change), copies those records into
+    //    `path_`.compact, and flushes it to the disk.
+    // 3. Under the mutex: appends the records written since `cut` (puts, updates and erases alike), renames the new log
+    //    over the log, and moves the index to it. Nothing is flushed here: like any record, the ones since `cut` reach the
+    //    disk with the next Flush().
+    // If that fails, the old log stays in use, the failure is counted (see TimerStoreStats), and the next attempt waits
+    // until the log has grown by compaction_min_bytes again. A compaction that the destructor stops is abandoned.
+    void Compact(const std::stop_token& stop) noexcept
+    {
+        const std::string compact_path = path_ + ".compact";
+        try {
+            std::vector<std::pair<uint64_t, Slot>> pending{};
+            std::size_t cut = 0;
+            std::size_t pending_bytes = 0;
+            {
+                std::lock_guard lock(mutex_);
+                pending.assign(index_.begin(), index_.end());
+                cut = end_;
+                pending_bytes = live_bytes_;
+            }
+
+            std::unordered_map<uint64_t, std::size_t> offsets{}; // (sequence -> offset in the new log)
+            offsets.reserve(pending.size());
+            std::size_t end = kHeaderSize;
+            MappedFile compact{};
+            compact.Open(compact_path, true);
+            compact.Resize(std::max(kInitialSize, (kHeaderSize + pending_bytes + sizeof(uint32_t)) * 2));
+            std::memcpy(compact.Data(), &kMagic, sizeof(kMagic));
+            {
+                MappedFile log{};
+                log.Open(path_, false); // (At least `cut` bytes: only a compaction shrinks the log)
+                for (const auto& [sequence, slot] : pending) {
+                    std::memcpy(compact.Data() + end, log.Data() + slot.offset_, slot.size_);
+                    offsets.emplace(sequence, end);
+                    end += slot.size_;
+                }
+            }
+            compact.Flush();
+
+            std::lock_guard lock(mutex_);
+            if (stop.stop_requested()) {
+                compact.Close();
+                std::remove(compact_path.c_str());
+                return;
+            }
+
+            const std::size_t tail = end_ - cut;
+            if (end + tail + sizeof(uint32_t) > compact.Size()) {
+                compact.Resize(std::max(end + tail + sizeof(uint32_t), compact.Size() * 2));
+            }
+            std::memcpy(compact.Data() + end, file_.Data() + cut, tail + sizeof(uint32_t)); // (With the end marker)
+
+            ReplaceLog(compact, compact_path);
+            for (auto& [sequence, slot] : index_) {
+                slot.offset_ = slot.offset_ >= cut ? end + (slot.offset_ - cut) : offsets.at(sequence);
+            }
+            end_ = end + tail;
+            retry_compaction_at_ = 0;
+            ++compactions_;
+        } catch (const std::exception&) {
+            std::remove(compact_path.c_str());
+            std::lock_guard lock(mutex_);
+            retry_compaction_at_ = end_ + compaction_min_bytes_;
+            ++compaction_failures_;
+        }
+    }
+
+    // ReplaceLog(compact, compact_path): Renames the compacted log over the log, and uses its mapping from then on.
+    // - POSIX: renamed while open, so the log is never closed. Windows does not rename files that are open: both are closed,
+    //   and the log is opened again after the rename (or, if it failed, the old log).
+    void ReplaceLog(MappedFile& compact, const std::string& compact_path)
+    {
+#if defined(_WIN32)
+        compact.Close();
+        file_.Close();
+        if (!MoveFileExA(compact_path.c_str(), path_.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+            const DWORD error = GetLastError();
+            file_.Open(path_, false);
+            throw std::system_error(static_cast<int>(error), std::system_category(), "MoveFileEx " + compact_path);
+        }
+        file_.Open(path_, false);
+#else
+        if (std::rename(compact_path.c_str(), path_.c_str()) != 0) {
+            throw std::system_error(errno, std::generic_category(), "rename " + compact_path);
+        }
+        file_.Swap(compact);
+#endif
+    }
+
+    const std::string path_;
+    const std::size_t compaction_min_bytes_;
+    const double compaction_ratio_;
+    mutable std::mutex mutex_{};
+    std::condition_variable_any compaction_requested_{};
+    bool compacting_{ false };
+    MappedFile file_{};
+    std::unordered_map<uint64_t, Slot> index_{}; // (sequence -> Slot)
+    std::size_t end_{ kHeaderSize };
+    std::size_t live_bytes_{ 0 };
+    uint64_t last_sequence_{ 0 };
+    uint64_t compactions_{ 0 };
+    uint64_t compaction_failures_{ 0 };
+    std::size_t retry_compaction_at_{ 0 };
+    std::jthread compactor_{};
+};
+
+#endif
@@ -0,0 +1,276 @@
+#ifndef AMITG_FC_TIMING_WHEEL
+#define AMITG_FC_TIMING_WHEEL
+
+/*
+    TimingWheel.h
+    Copyright (c) 2024, Amit Gefen
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+
+// TimingWheelHook: Intrusive links embedded in every node stored in a TimingWheel.
+// - A node is linked into exactly one circular list at a time (a wheel slot, or a list of expired nodes).
+// - Unlinking only needs the node itself, which is what makes removal O(1).
+
+struct TimingWheelHook
+{
+    TimingWheelHook* prev_{ nullptr };
+    TimingWheelHook* next_{ nullptr };
+    uint64_t expiry_tick_{ 0 };
+
+    bool IsLinked() const noexcept { return next_ != nullptr; }
+
+    void Unlink() noexcept
+    {
+        prev_->next_ = next_;
+        next_->prev_ = prev_;
+        prev_ = next_ = nullptr;
+    }
+};
+
+
+// TimingWheelList: Circular doubly-linked list of hooks with a sentinel head.
+
+class TimingWheelList final
+{
+public:
+
+    TimingWheelList() noexcept { head_.prev_ = head_.next_ = &head_; }
+
+    TimingWheelList(const TimingWheelList&) = delete;
+    TimingWheelList& operator=(const TimingWheelList&) = delete;
+
+    bool Empty() const noexcept { return head_.next_ == &head_; }
+
+    TimingWheelHook* Front() noexcept { return Empty() ? nullptr : head_.next_; }
+
+    void PushBack(TimingWheelHook* hook) noexcept
+    {
+        hook->prev_ = head_.prev_;
+        hook->next_ = &head_;
+        head_.prev_->next_ = hook;
+        head_.prev_ = hook;
+    }
+
+    // Moves all the hooks of `other` to the back of this list (O(1)).
+    void Splice(TimingWheelList& other) noexcept
+    {
+        if (other.Empty()) {
+            return;
+        }
+
+        TimingWheelHook* first = other.head_.next_;
+        TimingWheelHook* last = other.head_.prev_;
+        other.head_.prev_ = other.head_.next_ = &other.head_;
+
+        first->prev_ = head_.prev_;
+        last->next_ = &head_;
+        head_.prev_->next_ = first;
+        head_.prev_ = last;
+    }
+
+private:
+
+    TimingWheelHook head_{};
+};
+
+
+// TimingWheel<Node>
+//
+// Hierarchical timing wheel (Varghese & Lauck) with kLevels levels of kSlots slots each.
+// - Time is measured in ticks; the tick length is defined by the owner (the wheel only sees tick numbers).
+// - Insert() and Remove() are O(1). Advance() costs O(1) per expired or cascaded node plus a bounded slot scan
+//   per tick that has work; idle ticks are skipped.
+// - A node is placed on the level of the most significant slot digit in which its expiry tick differs from the
+//   current tick. When the lower digits of the current tick wrap to zero, the matching slot of the next level
+//   is cascaded (re-inserted) one level down. Expiries too far out for the top level wait in an overflow list.
+// - `Node` must derive from TimingWheelHook. The wheel does not own its nodes; the owner disposes of any that are left
+//   with Clear() before destroying it.
+// - Not thread-safe: the owner serializes all calls (the Scheduler only touches it on its engine strand).
+
+template <typename Node>
+class TimingWheel final
+{
+public:
+
+    static constexpr unsigned kSlotBits = 8;
+    static constexpr unsigned kSlots = 1u << kSlotBits;
+    static constexpr unsigned kLevels = 4;
+
+    explicit TimingWheel(const uint64_t current_tick = 0) noexcept : current_tick_(current_tick)
+    {
+    }
+
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+
+    // Clear(dispose)
+    //
+    // Unlinks every node and hands it to `dispose(Node*)`.
+    template <typename Dispose>
+    void Clear(Dispose&& dispose) noexcept
+    {
+        for (auto& level : levels_) {
+            for (auto& slot : level) {
+                ClearList(slot, dispose);
+            }
+        }
+        ClearList(overflow_, dispose);
+        size_ = 0;
+    }
+
+    uint64_t CurrentTick() const noexcept { return current_tick_; }
+
+    std::size_t Size() const noexcept { return size_; }
+
+    bool Empty() const noexcept { return size_ == 0; }
+
+    // Insert(node, expiry_tick)
+    //
+    // Links `node` into the wheel. An expiry tick that is not in the future expires on the next tick.
+    void Insert(Node* node, const uint64_t expiry_tick) noexcept
+    {
+        node->expiry_tick_ = expiry_tick > current_tick_ ? expiry_tick : current_tick_ + 1;
+        Place(node);
+        ++size_;
+    }
+
+    // Remove(node)
+    //
+    // Unlinks `node` from the wheel (ownership returns to the caller).
+    void Remove(Node* node) noexcept
+    {
+        node->Unlink();
+        --size_;
+    }
+
+    // Advance(now_tick, expired)
+    //
+    // Moves the wheel forward to `now_tick` and appends every node that expired on the way to `expired`.
+    // - Ticks without work (no expiry and no cascade) are skipped, so a long idle gap costs nothing.
+    // - Expired nodes are no longer counted by the wheel; the caller owns them.
+    // - The caller may re-insert nodes (e.g., from callbacks) after Advance() returns.
+    void Advance(const uint64_t now_tick, TimingWheelList& expired) noexcept
+    {
+        while (current_tick_ < now_tick) {
+            const auto next_tick = NextExpiryTick();
+            if (!next_tick || *next_tick > now_tick) {
+                current_tick_ = now_tick;
+                break;
+            }
+
+            current_tick_ = *next_tick;
+            Cascade();
+
+            auto& slot = levels_[0][current_tick_ & kSlotMask];
+            while (TimingWheelHook* hook = slot.Front()) {
+                hook->Unlink();
+                expired.PushBack(hook);
+                --size_;
+            }
+        }
+    }
+
+    // NextExpiryTick()
+    //
+    // Returns the next tick at which Advance() has work to do (an expiry, or a cascade that may lead to one),
+    // or std::nullopt if the wheel is empty. The owner arms its wake-up for that tick.
+    std::optional<uint64_t> NextExpiryTick() const noexcept
+    {
+        if (size_ == 0) {
+            return std::nullopt;
+        }
+
+        // The first non-empty slot after the current one, searching from the lowest level up.
+        // (Slots at or before the current digit of a level above 0 are always empty.)
+        for (unsigned level = 0; level < kLevels; ++level) {
+            const unsigned shift = kSlotBits * level;
+            const uint64_t digit = (current_tick_ >> shift) & kSlotMask;
+            const uint64_t rotation_base = (current_tick_ >> (shift + kSlotBits)) << (shift + kSlotBits);
+
+            for (uint64_t slot = digit + 1; slot < kSlots; ++slot) {
+                if (!levels_[level][slot].Empty()) {
+                    return rotation_base | (slot << shift);
+                }
+            }
+        }
+
+        // Only the overflow list is populated; it cascades when the top level wraps:
+        constexpr unsigned kTopShift = kSlotBits * kLevels;
+        return ((current_tick_ >> kTopShift) + 1) << kTopShift;
+    }
+
+private:
+
+    static constexpr uint64_t kSlotMask = kSlots - 1;
+
+    void Place(Node* node) noexcept
+    {
+        const uint64_t expiry_tick = node->expiry_tick_;
+        const uint64_t diff = expiry_tick ^ current_tick_;
+
+        for (unsigned level = 0; level < kLevels; ++level) {
+            if ((diff >> (kSlotBits * (level + 1))) == 0) {
+                levels_[level][(expiry_tick >> (kSlotBits * level)) & kSlotMask].PushBack(node);
+                return;
+            }
+        }
+
+        overflow_.PushBack(node);
+    }
+
+    // Re-distributes the higher-level slots whose range begins at current_tick_.
+    void Cascade() noexcept
+    {
+        for (unsigned level = 1; level <= kLevels; ++level) {
+            if (((current_tick_ >> (kSlotBits * (level - 1))) & kSlotMask) != 0) {
+                break;
+            }
+
+            auto& slot = level < kLevels ? levels_[level][(current_tick_ >> (kSlotBits * level)) & kSlotMask] : overflow_;
+            TimingWheelList pending{};
+            pending.Splice(slot);
+            while (TimingWheelHook* hook = pending.Front()) {
+                hook->Unlink();
+                Place(static_cast<Node*>(hook));
+            }
+        }
+    }
+
+    template <typename Dispose>
+    static void ClearList(TimingWheelList& list, Dispose& dispose) noexcept
+    {
+        while (TimingWheelHook* hook = list.Front()) {
+            hook->Unlink();
+            dispose(static_cast<Node*>(hook));
+        }
+    }
+
+    uint64_t current_tick_{ 0 };
+    std::size_t size_{ 0 };
+    std::array<std::array<TimingWheelList, kSlots>, kLevels> levels_{};
+    TimingWheelList overflow_{};
+};
+
+#endif
@@ -2,8 +2,13 @@
 //
 
 #include <syncstream>
+#include <cstdio>
 #include <iostream>
+#include <string_view>
+#include <vector>
+#include "RateLimiter.h"
 #include "Scheduler.h"
+#include "ShardedScheduler.h"
 
 
 namespace // (Anonymous namespace)
@@ -41,6 +46,50 @@ namespace // (Anonymous namespace)
     }
 
 
+    void TestMoveOnlyPayload()
+    {
+        std::cout << "* test move-only payloads (moved into the timer once, and into the callback when it fires)" << std::endl;
+
+        // Counts its copies and moves
+        struct CountedPayload {
+            CountedPayload(std::atomic<int>& copies, std::atomic<int>& moves) : copies_(copies), moves_(moves) {}
+            CountedPayload(const CountedPayload& other) : copies_(other.copies_), moves_(other.moves_) { copies_.fetch_add(1); }
+            CountedPayload(CountedPayload&& other) noexcept : copies_(other.copies_), moves_(other.moves_) { moves_.fetch_add(1); }
+            std::atomic<int>& copies_;
+            std::atomic<int>& moves_;
+        };
+        std::atomic<int> copies{ 0 };
+        std::atomic<int> moves{ 0 };
+
+        Scheduler scheduler{};
+
+        // A move-only argument: the 1 MB buffer reaches the callback without being copied (same address)
+        auto buffer = std::make_unique<std::vector<std::byte>>(std::size_t{ 1 } << 20);
+        const std::byte* address = buffer->data();
+        scheduler.ScheduleTimer(1, 100, [address](uint64_t timer_id, std::unique_ptr<std::vector<std::byte>> buffer) {
+            std::osyncstream sync_stream(std::cout);
+            sync_stream << "timer " << timer_id << " got a " << buffer->size() << " byte buffer, "
+                << (buffer->data() == address ? "not copied" : "COPIED") << std::endl;
+            }, std::move(buffer)); // <--
+
+        // A move-only callback: a lambda that owns its state
+        auto greeting = std::make_unique<std::string>("hello from a move-only lambda");
+        scheduler.ScheduleTimer(2, 200, [greeting = std::move(greeting)](uint64_t timer_id) {
+            std::osyncstream sync_stream(std::cout);
+            sync_stream << "timer " << timer_id << ": " << *greeting << std::endl;
+            }); // <--
+
+        // A counted argument: one move into the timer node, no copy (the callback takes it by rvalue reference)
+        scheduler.ScheduleTimer(3, 300, [](uint64_t timer_id, CountedPayload&& payload) {
+            std::osyncstream sync_stream(std::cout);
+            sync_stream << "timer " << timer_id << ": copies " << payload.copies_.load() << ", moves " << payload.moves_.load() << std::endl; // <-- (0, 1)
+            }, CountedPayload(copies, moves)); // <--
+
+        // Sleep for a while to let the timers expire
+        std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    }
+
+
     // Function Callback__
 
     void OnTimer(uint64_t timer_id)
@@ -103,6 +152,515 @@ namespace // (Anonymous namespace)
     }
 
 
+    void TestTimingWheelEngine()
+    {
+        std::cout << "* test timing wheel engine" << std::endl;
+
+        Scheduler scheduler{ SchedulerOptions{ .engine = TimerEngine::TimingWheel } };
+
+        for (uint64_t timer_id = 1; timer_id <= 3; ++timer_id) {
+            scheduler.ScheduleTimer(timer_id, static_cast<uint32_t>(timer_id * 500), OnTimer); // <--
+        }
+
+        // Sleep for a while to let the timers expire
+        std::this_thread::sleep_for(std::chrono::seconds(2));
+    }
+
+
+#if defined(SCHEDULER_USE_TIMERFD)
+    void TestTimerFd()
+    {
+        std::cout << "* test timerfd wheel timer (past deadlines, re-arm to an earlier expiry, cancel & re-arm)" << std::endl;
+
+        boost::asio::io_context io_context{};
+        TimerFd timer{ io_context };
+
+        // Arms `timer` for `expiry` and queues a wait that records its outcome; `run` times the waits
+        std::vector<std::string> outcomes{};
+        const auto wait = [&timer, &outcomes](const std::chrono::steady_clock::time_point expiry) {
+            timer.expires_at(expiry);
+            timer.async_wait([&outcomes](const boost::system::error_code& e) {
+                outcomes.push_back(e == boost::asio::error::operation_aborted ? "aborted" : (e ? e.message() : "expired"));
+                });
+            };
+        const auto run = [&io_context] {
+            const auto start = std::chrono::steady_clock::now();
+            io_context.restart();
+            io_context.run();
+            return std::chrono::steady_clock::now() - start;
+            };
+        const auto yes = [](const bool condition) { return condition ? "yes" : "NO"; };
+
+        // A deadline in the past, and the clock's epoch (an all-zero time, armed as 1 ns): both expire at once
+        wait(std::chrono::steady_clock::now() - std::chrono::seconds(1));
+        auto elapsed = run();
+        wait(std::chrono::steady_clock::time_point{});
+        elapsed += run();
+        std::cout << "past deadlines expire at once: "
+            << yes(outcomes == std::vector<std::string>{ "expired", "expired" } && elapsed < std::chrono::milliseconds(100)) << std::endl; // <-- (yes)
+
+        // A pending wait re-armed to an earlier expiry: the first wait is aborted, the second expires early, not at 1 s
+        outcomes.clear();
+        wait(std::chrono::steady_clock::now() + std::chrono::seconds(1));
+        wait(std::chrono::steady_clock::now() + std::chrono::milliseconds(50));
+        elapsed = run();
+        std::cout << "re-armed to an earlier expiry: "
+            << yes(outcomes == std::vector<std::string>{ "aborted", "expired" } && elapsed >= std::chrono::milliseconds(50) && elapsed < std::chrono::milliseconds(500)) << std::endl; // <-- (yes)
+
+        // A cancelled wait, then a new one: the cancel aborts the first, and leaves no readiness to end the second early
+        outcomes.clear();
+        wait(std::chrono::steady_clock::now() + std::chrono::milliseconds(20));
+        timer.cancel();
+        wait(std::chrono::steady_clock::now() + std::chrono::milliseconds(100));
+        elapsed = run();
+        std::cout << "cancelled, then re-armed: "
+            << yes(outcomes == std::vector<std::string>{ "aborted", "expired" } && elapsed >= std::chrono::milliseconds(100) && elapsed < std::chrono::milliseconds(500)) << std::endl; // <-- (yes)
+    }
+#endif
+
+
+    void TestCancelAndReschedule()
+    {
+        std::cout << "* test cancel & reschedule by timer id" << std::endl;
+
+        Scheduler scheduler{};
+
+        scheduler.ScheduleTimer(1, 500, OnTimer);
+        scheduler.ScheduleTimer(2, 1000, OnTimer);
+        scheduler.ScheduleTimer(3, 1500, OnTimer);
+
+        scheduler.CancelTimer(2); // <-- (timer 2 never expires)
+        scheduler.RescheduleTimer(1, 2000); // <-- (timer 1 expires after timer 3)
+
+        // Sleep for a while to let the timers expire
+        std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+    }
+
+
+    void TestWorkerThreads()
+    {
+        std::cout << "* test worker thread pool (4 threads)" << std::endl;
+
+        Scheduler scheduler{ SchedulerOptions{ .worker_threads = 4 } };
+
+        // The four callbacks are slow, yet all of them complete about 1 second after they expire:
+        for (uint64_t timer_id = 1; timer_id <= 4; ++timer_id) {
+            scheduler.ScheduleTimer(timer_id, 500, [](uint64_t timer_id) {
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+                OnTimer(timer_id);
+                }); // <--
+        }
+
+        // Sleep for a while to let the timers expire
+        std::this_thread::sleep_for(std::chrono::seconds(2));
+    }
+
+
+    void TestPeriodicTimer()
+    {
+        std::cout << "* test periodic timer (every 500 ms, drift-free)" << std::endl;
+
+        Scheduler scheduler{};
+
+        scheduler.SchedulePeriodic(1, 500, CatchUpPolicy::Coalesce, OnTimer); // <--
+
+        // Let it tick 4 times, then stop it
+        std::this_thread::sleep_for(std::chrono::milliseconds(2250));
+        scheduler.CancelTimer(1);
+    }
+
+
+    void TestChronoDeadlines()
+    {
+        std::cout << "* test std::chrono durations & steady_clock deadlines" << std::endl;
+
+        Scheduler scheduler{};
+
+        scheduler.ScheduleTimer(1, std::chrono::microseconds(250), OnTimer); // <-- (sub-millisecond)
+        scheduler.ScheduleTimer(2, std::chrono::steady_clock::now() + std::chrono::milliseconds(500), OnTimer); // <-- (absolute)
+
+        // Sleep for a while to let the timers expire
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+
+
+    void TestBatchScheduling()
+    {
+        std::cout << "* test batch schedule & cancel" << std::endl;
+
+        Scheduler scheduler{};
+
+        const std::vector<TimerSpec> specs{ { 1, 300 }, { 2, 600 }, { 3, 900 }, { 4, 1200 } };
+        scheduler.ScheduleTimers(specs, OnTimer); // <-- (one hand-off for the whole batch)
+
+        const std::vector<uint64_t> cancelled{ 2, 4 };
+        scheduler.CancelTimers(cancelled); // <--
+
+        // Sleep for a while to let the timers expire
+        std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    }
+
+
+    void TestStats()
+    {
+        std::cout << "* test stats (lateness & callback run time)" << std::endl;
+
+        Scheduler scheduler{};
+
+        for (uint64_t timer_id = 1; timer_id <= 100; ++timer_id) {
+            scheduler.ScheduleTimer(timer_id, std::chrono::milliseconds(timer_id), [](uint64_t) {});
+        }
+        scheduler.CancelTimer(100);
+
+        // Sleep for a while to let the timers expire
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+        const SchedulerStats stats = scheduler.Stats(); // <--
+        std::cout << "fired " << stats.fired << ", cancelled " << stats.cancelled << ", active " << stats.active_timers
+            << ", lateness p50 " << stats.lateness.Percentile(50).count() << " ns, p99 " << stats.lateness.Percentile(99).count()
+            << " ns, max " << stats.lateness.Max().count() << " ns" << std::endl;
+    }
+
+
+    void TestTimerSlack()
+    {
+        std::cout << "* test timer slack (5 timers in one 33 ms grid cell: one wakeup, in deadline order; 1 exact timer: one more)" << std::endl;
+
+        Scheduler scheduler{ SchedulerOptions{ .timer_slack = std::chrono::milliseconds(50), .adaptive_slack = false } };
+
+        // The grid is 2^25 ns (the largest power of two below the slack), counted from the Scheduler's start: the cell from
+        // 503 to 537 ms holds all five deadlines. (Timers straddling a cell boundary would take two wakeups.) They are
+        // scheduled out of order, and expire in the order of their deadlines all the same.
+        std::mutex mutex{};
+        std::vector<uint64_t> expired{};
+        const auto on_timer = [&mutex, &expired](uint64_t timer_id) {
+            const std::lock_guard lock(mutex);
+            expired.push_back(timer_id);
+            };
+        for (const uint64_t timer_id : { 3, 1, 5, 2, 4 }) {
+            scheduler.ScheduleTimer(timer_id, std::chrono::milliseconds(510 + 2 * timer_id), on_timer); // <--
+        }
+        scheduler.ScheduleTimer(6, TimerDeadline(std::chrono::milliseconds(1000)).WithSlack(std::chrono::milliseconds(0)), on_timer); // <-- (exact)
+
+        // Sleep for a while to let the timers expire
+        std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+        const std::lock_guard lock(mutex);
+        const bool in_order = expired == std::vector<uint64_t>{ 1, 2, 3, 4, 5, 6 };
+        std::cout << "wakeups: " << scheduler.Stats().wakeups << ", expired in deadline order: " << (in_order ? "yes" : "NO") << std::endl; // <-- (2, yes)
+    }
+
+
+    void TestPrecisionMode()
+    {
+        std::cout << "* test precision mode (wake up 200 us early, then spin to the deadline)" << std::endl;
+
+        Scheduler scheduler{ SchedulerOptions{ .precision_spin = std::chrono::microseconds(200) } };
+
+        for (uint64_t timer_id = 1; timer_id <= 5; ++timer_id) {
+            scheduler.ScheduleTimer(timer_id, std::chrono::milliseconds(100 * timer_id), OnTimer); // <--
+        }
+
+        // Sleep for a while to let the timers expire
+        std::this_thread::sleep_for(std::chrono::milliseconds(700));
+        const SchedulerStats stats = scheduler.Stats();
+        std::cout << "lateness p99: " << stats.precision_lateness.Percentile(99).count() << " ns, spin p50: "
+            << stats.spin_time.Percentile(50).count() << " ns" << std::endl;
+    }
+
+
+    void TestCallbackErrors()
+    {
+        std::cout << "* test callback errors (a throwing callback does not stop the Scheduler)" << std::endl;
+
+        Scheduler scheduler{ SchedulerOptions{
+            .callback_error_policy = CallbackErrorPolicy::Handler,
+            .callback_error_handler = [](const uint64_t timer_id, const std::exception_ptr error) {
+                try {
+                    std::rethrow_exception(error);
+                } catch (const std::exception& e) {
+                    std::cout << "timer " << timer_id << " threw: " << e.what() << std::endl;
+                }
+                } } };
+
+        scheduler.ScheduleTimer(1, 100u, [](uint64_t) { throw std::runtime_error("out of range"); }); // <--
+        scheduler.ScheduleTimer(2, 200u, OnTimer); // <-- (still fires)
+
+        // Sleep for a while to let the timers expire
+        std::this_thread::sleep_for(std::chrono::milliseconds(400));
+        std::cout << "callback errors: " << scheduler.Stats().callback_errors << std::endl;
+    }
+
+
+    void TestDebounceThrottle()
+    {
+        std::cout << "* test debounce & throttle (bursts of calls on one key)" << std::endl;
+
+        Scheduler scheduler{};
+
+        for (int keystroke = 1; keystroke <= 10; ++keystroke) {
+            scheduler.Debounce(1, 200u, [keystroke](uint64_t) { std::cout << "debounced: keystroke " << keystroke << std::endl; }); // <-- (only the last fires)
+            scheduler.Throttle(2, 100u, [keystroke](uint64_t) { std::cout << "throttled: event " << keystroke << std::endl; }); // <-- (first and last fire)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        // Sleep for a while to let the timers expire
+        std::this_thread::sleep_for(std::chrono::milliseconds(400));
+        std::cout << "suppressed calls: " << scheduler.Stats().suppressed << std::endl;
+    }
+
+
+    void TestIdleTimeout()
+    {
+        std::cout << "* test idle timeout (touched for 300 ms, then idle for 100 ms)" << std::endl;
+
+        Scheduler scheduler{};
+
+        const auto start = std::chrono::steady_clock::now();
+        IdleTimeout session = scheduler.ScheduleIdleTimeout(1, 100u, [start](uint64_t timer_id) {
+            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+            std::cout << "session " << timer_id << " idle, closed after " << elapsed.count() << " ms" << std::endl;
+            });
+
+        for (int packet = 0; packet < 30; ++packet) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            session.Touch(); // <-- (no re-arming)
+        }
+
+        // Sleep for a while to let the session time out
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+
+    void TestPersistentTimers()
+    {
+        std::cout << "* test persistent timers (scheduled before a restart, fired after it)" << std::endl;
+
+        const std::string path = "persistent_timers_demo.log";
+        std::remove(path.c_str());
+
+        SchedulerOptions options{};
+        options.timer_store.path = path;
+        options.timer_store.handler = [](uint64_t timer_id, std::span<const std::byte> payload) {
+            std::osyncstream sync_stream(std::cout);
+            sync_stream << "persistent timer " << timer_id << " fired: "
+                << std::string_view(reinterpret_cast<const char*>(payload.data()), payload.size()) << std::endl;
+            };
+
+        const auto bytes = [](std::string_view text) { return std::as_bytes(std::span(text.data(), text.size())); };
+
+        {
+            Scheduler scheduler{ options };
+            scheduler.SchedulePersistent(1, 200u, bytes("retry order 17"));
+            scheduler.SchedulePersistent(2, 300u, bytes("send reminder"));
+            scheduler.SchedulePersistent(3, 400u, bytes("cancelled"));
+            scheduler.CancelTimer(3);
+        } // <-- ("process exits": timers 1 & 2 stay in the store)
+
+        {
+            Scheduler scheduler{ options }; // <-- (reloads timers 1 & 2)
+            std::cout << "reloaded " << scheduler.StoreStats().pending << " pending timers" << std::endl;
+
+            // Sleep for a while to let the reloaded timers expire
+            std::this_thread::sleep_for(std::chrono::milliseconds(400));
+        }
+
+        std::remove(path.c_str());
+    }
+
+
+    void TestPersistentReplaceRace()
+    {
+        std::cout << "* test persistent replace race (2 threads schedule each of 10000 ids at once: each fires once)" << std::endl;
+
+        const std::string path = "persistent_race_demo.log";
+        std::remove(path.c_str());
+
+        constexpr uint64_t kTimers = 10000;
+        std::vector<std::atomic<int>> fired(kTimers + 1);
+
+        SchedulerOptions options{};
+        options.timer_store.path = path;
+        options.timer_store.handler = [&fired](uint64_t timer_id, std::span<const std::byte>) {
+            fired[timer_id].fetch_add(1);
+            };
+
+        {
+            Scheduler scheduler{ options };
+
+            // Both threads put a record for every id; the engine keeps whichever call it applies last, and erases the other's
+            // record only (not the survivor's, whichever sequence it has)
+            std::atomic<bool> go{ false };
+            const auto schedule_all = [&scheduler, &go](std::string_view text) {
+                while (!go.load()) {
+                }
+                for (uint64_t timer_id = 1; timer_id <= kTimers; ++timer_id) {
+                    scheduler.SchedulePersistent(timer_id, 100u, std::as_bytes(std::span(text.data(), text.size())));
+                }
+                };
+            {
+                std::jthread a(schedule_all, "a");
+                std::jthread b(schedule_all, "b");
+                go.store(true);
+            }
+
+            // Sleep for a while to let the timers expire
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+            uint64_t once = 0;
+            for (uint64_t timer_id = 1; timer_id <= kTimers; ++timer_id) {
+                once += fired[timer_id].load() == 1 ? 1 : 0;
+            }
+            std::cout << "fired once: " << once << " of " << kTimers << ", left in the store: " << scheduler.StoreStats().pending << std::endl; // <-- (10000 of 10000, 0)
+        }
+
+        std::remove(path.c_str());
+    }
+
+
+    void TestRateLimiter()
+    {
+        std::cout << "* test rate limiter (10 requests/second, bursts of 3)" << std::endl;
+
+        Scheduler scheduler{};
+        RateLimiter limiter{ scheduler, 100 /*refill timer_id*/, RateLimiterOptions{ .rate = 10, .burst = 3 } };
+
+        for (int request = 1; request <= 5; ++request) {
+            std::cout << "request " << request << (limiter.TryAcquire() ? ": admitted" : ": rejected") << std::endl; // <-- (3 admitted)
+        }
+
+        for (int request = 6; request <= 8; ++request) {
+            limiter.Acquire(1, [request] { std::cout << "request " << request << ": admitted after waiting" << std::endl; }); // <-- (every 100 ms)
+        }
+
+        // Sleep for a while to let the tokens refill
+        std::this_thread::sleep_for(std::chrono::milliseconds(400));
+        std::cout << "refill wakeups: " << limiter.Stats().wakeups << std::endl;
+    }
+
+
+    void TestShutdown()
+    {
+        std::cout << "* test shutdown (drain until a 1 second deadline)" << std::endl;
+
+        Scheduler scheduler{};
+
+        for (uint64_t timer_id = 1; timer_id <= 4; ++timer_id) {
+            scheduler.ScheduleTimer(timer_id, static_cast<uint32_t>(timer_id * 400), OnTimer);
+        }
+
+        const ShutdownReport report = scheduler.Shutdown(ShutdownPolicy::DrainUntilDeadline, std::chrono::seconds(1)); // <-- (timers 1 & 2 fire)
+        std::cout << "fired " << report.fired << ", dropped " << report.dropped << ", in flight " << report.in_flight << std::endl;
+    }
+
+
+    Task<uint64_t> CountDown(Scheduler& scheduler, const uint64_t id, int n)
+    {
+        for (; n > 0; --n) {
+            co_await scheduler.SleepFor(std::chrono::milliseconds(300 + 100 * id)); // <-- (no thread blocked while waiting)
+
+            std::osyncstream sync_stream(std::cout);
+            sync_stream << "coroutine " << id << ": " << n << std::endl;
+        }
+        co_return id;
+    }
+
+
+    void TestCoroutines()
+    {
+        std::cout << "* test coroutines (3 count-downs awaiting SleepFor)" << std::endl;
+
+        Scheduler scheduler{};
+
+        std::vector<std::future<uint64_t>> results{};
+        for (uint64_t id = 1; id <= 3; ++id) {
+            results.push_back(scheduler.Spawn(CountDown(scheduler, id, 3))); // <--
+        }
+
+        for (auto& result : results) {
+            const uint64_t id = result.get();
+            std::osyncstream(std::cout) << "coroutine " << id << " done" << std::endl;
+        }
+    }
+
+
+    void TestCompletionHandle()
+    {
+        std::cout << "* test completion handles (result, cancellation)" << std::endl;
+
+        Scheduler scheduler{};
+
+        TimerCompletion<int> sum = scheduler.ScheduleTimerCompletion(1, 300, [](uint64_t, int a, int b) { return a + b; }, 20, 22); // <--
+        TimerCompletion<void> cancelled = scheduler.ScheduleTimerCompletion(2, 600, OnTimer); // <--
+        scheduler.CancelTimer(2);
+
+        std::cout << "timer 1 returned " << *sum.Get() << ", timer 2 fired: " << std::boolalpha << cancelled.Get() << std::endl;
+    }
+
+
+    void TestExternalIoContext()
+    {
+        std::cout << "* test 1000 models sharing one io_context (no scheduler thread)" << std::endl;
+
+        class Model final
+        {
+        public:
+
+            Model(boost::asio::io_context& io_context, std::atomic<int>& fired) : fired_(fired), scheduler_(io_context) // <--
+            {
+                scheduler_.ScheduleTimer(1, 500, &Model::OnTimer, this);
+            }
+
+        private:
+            std::atomic<int>& fired_;
+            Scheduler scheduler_;
+
+            void OnTimer(uint64_t)
+            {
+                fired_.fetch_add(1);
+            }
+        };
+
+        boost::asio::io_context io_context{};
+        std::atomic<int> fired{ 0 };
+
+        std::vector<std::unique_ptr<Model>> models{};
+        for (int i = 0; i < 1000; ++i) {
+            models.push_back(std::make_unique<Model>(io_context, fired));
+        }
+
+        io_context.run(); // <-- (This thread runs the timers of all the models; returns once they have fired)
+        std::cout << "fired " << fired << " timers" << std::endl;
+    }
+
+
+    void TestShardedScheduler()
+    {
+        std::cout << "* test sharded scheduler (4 pinned shards, timers routed by id)" << std::endl;
+
+        ShardedScheduler scheduler{ ShardedSchedulerOptions{ .shards = 4 } };
+
+        for (uint64_t timer_id = 1; timer_id <= 8; ++timer_id) {
+            scheduler.ScheduleTimer(timer_id, static_cast<uint32_t>(timer_id * 100), OnTimer); // <-- (on shard ShardOf(timer_id))
+        }
+        scheduler.CancelTimer(8); // <-- (reaches the same shard)
+
+        std::vector<TimerSpec> specs{};
+        for (uint64_t timer_id = 9; timer_id <= 16; ++timer_id) {
+            specs.push_back(TimerSpec{ timer_id, static_cast<uint32_t>((timer_id - 8) * 100) });
+        }
+        scheduler.ScheduleTimers(specs, OnTimer); // <-- (split into one batch per shard)
+        scheduler.CancelTimers(std::vector<uint64_t>{ 15, 16 }); // <--
+
+        // Sleep for a while to let the timers expire
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+
+        const std::vector<SchedulerStats> shards = scheduler.ShardStats(); // <--
+        for (std::size_t shard = 0; shard < shards.size(); ++shard) {
+            std::cout << "shard " << shard << ": fired " << shards[shard].fired << ", cancelled " << shards[shard].cancelled << std::endl;
+        }
+    }
+
+
     void TestEndCases()
     {
         std::cout << "* test end cases" << std::endl;
@@ -116,8 +674,32 @@ namespace // (Anonymous namespace)
 int main()
 {
     TestGenericCallback();
+    TestMoveOnlyPayload();
     TestFunctionCallback2Timers();
     TestMemberFunctionCallback_PlusExtraParameter_PlusReschedule();
+    TestTimingWheelEngine();
+#if defined(SCHEDULER_USE_TIMERFD)
+    TestTimerFd();
+#endif
+    TestCancelAndReschedule();
+    TestWorkerThreads();
+    TestPeriodicTimer();
+    TestChronoDeadlines();
+    TestBatchScheduling();
+    TestStats();
+    TestTimerSlack();
+    TestPrecisionMode();
+    TestCallbackErrors();
+    TestDebounceThrottle();
+    TestIdleTimeout();
+    TestPersistentTimers();
+    TestPersistentReplaceRace();
+    TestRateLimiter();
+    TestShutdown();
+    TestCoroutines();
+    TestCompletionHandle();
+    TestExternalIoContext();
+    TestShardedScheduler();
  //   TestEndCases();
 }
 